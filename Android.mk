@@ -3,7 +3,7 @@
 include $(CLEAR_VARS)
 LOCAL_MODULE    := a3d
 LOCAL_CFLAGS    := -Wall -D$(A3D_CLIENT_VERSION)
-LOCAL_SRC_FILES := a3d/a3d_log.c a3d/a3d_glsm.c a3d/a3d_unit.c a3d/a3d_timestamp.c a3d/a3d_list.c \
+LOCAL_SRC_FILES := a3d/a3d_log.c a3d/a3d_glsm.c a3d/a3d_unit.c a3d/a3d_timestamp.c a3d/a3d_list.c a3d/a3d_array.c a3d/a3d_intmap.c a3d/a3d_sharedmap.c \
                    a3d/a3d_texfont.c a3d/a3d_texstring.c a3d/a3d_workq.c a3d/a3d_cache.c \
                    a3d/math/a3d_mat3f.c a3d/math/a3d_mat4f.c a3d/math/a3d_stack4f.c a3d/math/a3d_regionf.c a3d/math/a3d_vec2f.c a3d/math/a3d_vec3f.c a3d/math/a3d_vec4f.c \
                    a3d/math/a3d_quaternion.c a3d/math/a3d_orientation.c a3d/math/a3d_sphere.c a3d/math/a3d_plane.c a3d/math/a3d_fplane.c a3d/a3d_GL.c \
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "a3d_array.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#define LOG_TAG "a3d"
+#include "a3d_log.h"
+
+// minimum capacity for a non-empty array
+#define A3D_ARRAY_MIN_CAPACITY 16
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int a3d_array_grow(a3d_array_t* self, int size)
+{
+	assert(self);
+	LOGD("debug size=%i", size);
+
+	if(size <= self->capacity)
+	{
+		return 1;
+	}
+
+	// double the capacity for amortized constant time push
+	int capacity = 2*self->capacity;
+	if(capacity < A3D_ARRAY_MIN_CAPACITY)
+	{
+		capacity = A3D_ARRAY_MIN_CAPACITY;
+	}
+	if(capacity < size)
+	{
+		capacity = size;
+	}
+
+	return a3d_array_reserve(self, capacity);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+a3d_array_t* a3d_array_new(int elem_size)
+{
+	assert(elem_size > 0);
+	LOGD("debug elem_size=%i", elem_size);
+
+	a3d_array_t* self = (a3d_array_t*) malloc(sizeof(a3d_array_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->size      = 0;
+	self->capacity  = 0;
+	self->elem_size = elem_size;
+	self->data      = NULL;
+
+	return self;
+}
+
+void a3d_array_delete(a3d_array_t** _self)
+{
+	assert(_self);
+
+	a3d_array_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		free(self->data);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+void a3d_array_clear(a3d_array_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	// keep the capacity so the array may be refilled
+	// without reallocating
+	self->size = 0;
+}
+
+int a3d_array_size(const a3d_array_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	return self->size;
+}
+
+int a3d_array_empty(const a3d_array_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	return self->size == 0;
+}
+
+void* a3d_array_data(const a3d_array_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	// the data pointer is invalidated by operations
+	// which increase the capacity
+	return self->data;
+}
+
+void* a3d_array_get(const a3d_array_t* self, int idx)
+{
+	assert(self);
+	assert((idx >= 0) && (idx < self->size));
+	LOGD("debug idx=%i", idx);
+
+	return (void*) ((char*) self->data + idx*self->elem_size);
+}
+
+void* a3d_array_peektail(const a3d_array_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	if(self->size == 0)
+	{
+		return NULL;
+	}
+
+	return a3d_array_get(self, self->size - 1);
+}
+
+int a3d_array_reserve(a3d_array_t* self, int capacity)
+{
+	assert(self);
+	assert(capacity >= 0);
+	LOGD("debug capacity=%i", capacity);
+
+	if(capacity <= self->capacity)
+	{
+		return 1;
+	}
+
+	void* data = realloc(self->data, capacity*self->elem_size);
+	if(data == NULL)
+	{
+		LOGE("realloc failed");
+		return 0;
+	}
+
+	self->capacity = capacity;
+	self->data     = data;
+
+	return 1;
+}
+
+int a3d_array_resize(a3d_array_t* self, int size)
+{
+	assert(self);
+	assert(size >= 0);
+	LOGD("debug size=%i", size);
+
+	// new elements are uninitialized
+	if(a3d_array_grow(self, size) == 0)
+	{
+		return 0;
+	}
+
+	self->size = size;
+
+	return 1;
+}
+
+int a3d_array_push(a3d_array_t* self, const void* elem)
+{
+	assert(self);
+	assert(elem);
+	LOGD("debug");
+
+	if(a3d_array_grow(self, self->size + 1) == 0)
+	{
+		return 0;
+	}
+
+	memcpy((char*) self->data + self->size*self->elem_size,
+	       elem, self->elem_size);
+	++self->size;
+
+	return 1;
+}
+
+int a3d_array_pop(a3d_array_t* self, void* elem)
+{
+	// elem may be NULL
+	assert(self);
+	LOGD("debug");
+
+	if(self->size == 0)
+	{
+		return 0;
+	}
+
+	--self->size;
+	if(elem)
+	{
+		memcpy(elem,
+		       (char*) self->data + self->size*self->elem_size,
+		       self->elem_size);
+	}
+
+	return 1;
+}
+
+int a3d_array_append(a3d_array_t* self, int count,
+                     const void* elems)
+{
+	assert(self);
+	assert(count >= 0);
+	assert(elems || (count == 0));
+	LOGD("debug count=%i", count);
+
+	if(count == 0)
+	{
+		return 1;
+	}
+
+	if(a3d_array_grow(self, self->size + count) == 0)
+	{
+		return 0;
+	}
+
+	memcpy((char*) self->data + self->size*self->elem_size,
+	       elems, count*self->elem_size);
+	self->size += count;
+
+	return 1;
+}
+
+void a3d_array_sort(a3d_array_t* self,
+                    a3d_arraycmp_fn compare)
+{
+	assert(self);
+	assert(compare);
+	LOGD("debug");
+
+	// note that qsort is not stable
+	if(self->size > 1)
+	{
+		qsort(self->data, self->size, self->elem_size, compare);
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef a3d_array_H
+#define a3d_array_H
+
+// compares the elements pointed to by a and b
+typedef int (*a3d_arraycmp_fn)(const void* a, const void* b);
+
+// growable array which stores elements contiguously
+// so the data may be passed directly to GL
+typedef struct
+{
+	int   size;
+	int   capacity;
+	int   elem_size;
+	void* data;
+} a3d_array_t;
+
+a3d_array_t* a3d_array_new(int elem_size);
+void         a3d_array_delete(a3d_array_t** _self);
+void         a3d_array_clear(a3d_array_t* self);
+int          a3d_array_size(const a3d_array_t* self);
+int          a3d_array_empty(const a3d_array_t* self);
+void*        a3d_array_data(const a3d_array_t* self);
+void*        a3d_array_get(const a3d_array_t* self, int idx);
+void*        a3d_array_peektail(const a3d_array_t* self);
+int          a3d_array_reserve(a3d_array_t* self, int capacity);
+int          a3d_array_resize(a3d_array_t* self, int size);
+int          a3d_array_push(a3d_array_t* self, const void* elem);
+int          a3d_array_pop(a3d_array_t* self, void* elem);
+int          a3d_array_append(a3d_array_t* self, int count,
+                              const void* elems);
+void         a3d_array_sort(a3d_array_t* self,
+                            a3d_arraycmp_fn compare);
+
+#endif
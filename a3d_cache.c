@@ -38,6 +38,12 @@ typedef struct
 	int          size;
 	void*        data;
 	a3d_cache_t* cache;
+
+	// evicted while loading so purge_fn frees the node
+	int evict;
+
+	// lru link which is also the cache key
+	a3d_listitem_t item;
 } a3d_cachenode_t;
 
 static a3d_cachenode_t* a3d_cachenode_new(void* data, a3d_cache_t* cache)
@@ -57,6 +63,7 @@ static a3d_cachenode_t* a3d_cachenode_new(void* data, a3d_cache_t* cache)
 	self->size   = 0;
 	self->data   = data;
 	self->cache  = cache;
+	self->evict  = 0;
 
 	return self;
 }
@@ -84,7 +91,7 @@ static int a3d_cache_runfn(int tid, void* owner, void* task)
 	LOGD("debug");
 
 	a3d_listitem_t*  key   = (a3d_listitem_t*)  task;
-	a3d_cachenode_t* n     = (a3d_cachenode_t*) a3d_list_peekitem(key);
+	a3d_cachenode_t* n     = a3d_list_container(key, a3d_cachenode_t, item);
 	a3d_cache_t*     cache = n->cache;
 
 	return (*cache->load_fn)(n->data);
@@ -97,15 +104,49 @@ static void a3d_cache_purgefn(void* owner, void* task, int status)
 	LOGD("debug");
 
 	a3d_listitem_t*  key   = (a3d_listitem_t*)  task;
-	a3d_cachenode_t* n     = (a3d_cachenode_t*) a3d_list_peekitem(key);
+	a3d_cachenode_t* n     = a3d_list_container(key, a3d_cachenode_t, item);
 	a3d_cache_t*     cache = n->cache;
 
+	// the load of an evicted item has completed
+	if(n->evict)
+	{
+		(*cache->evict_fn)(n->data);
+		a3d_cachenode_delete(&n);
+		return;
+	}
+
 	// items which have been purged from the workq are not likely
 	// to be needed again so move them to the beginning of the
 	// cache so they are the first to be evicted
 	a3d_list_move(cache->lru, key, a3d_list_head(cache->lru));
 }
 
+static void a3d_cache_evict(a3d_cache_t* self, a3d_cachenode_t* n)
+{
+	assert(self);
+	assert(n);
+	LOGD("debug");
+
+	// the node must already be removed from the lru
+	++self->count_evict;
+
+	// a load in progress cannot be interrupted so rather
+	// than waiting for it the node is freed by purge_fn
+	// once the load completes
+	if(a3d_workq_cancelAsync(self->loader, (void*) &n->item) ==
+	   A3D_WORKQ_PENDING)
+	{
+		self->size -= n->size;
+		n->size     = 0;
+		n->status   = A3D_CACHE_ERROR;
+		n->evict    = 1;
+		return;
+	}
+
+	(*self->evict_fn)(n->data);
+	a3d_cachenode_delete(&n);
+}
+
 static void a3d_cache_trim(a3d_cache_t* self, a3d_listitem_t* key)
 {
 	// key may be NULL
@@ -123,23 +164,19 @@ static void a3d_cache_trim(a3d_cache_t* self, a3d_listitem_t* key)
 		}
 
 		a3d_cachenode_t* n;
-		a3d_workq_cancel(self->loader, (void*) iter);
 		n = (a3d_cachenode_t*) a3d_list_remove(self->lru, &iter);
-		(*self->evict_fn)(n->data);
-		a3d_cachenode_delete(&n);
-		++self->count_evict;
+		a3d_cache_evict(self, n);
 	}
 }
 
-/***********************************************************
-* public                                                   *
-***********************************************************/
-
-a3d_cache_t* a3d_cache_new(int max_size,
-                           a3d_cacheload_fn  load_fn,
-                           a3d_cachestore_fn store_fn,
-                           a3d_cacheevict_fn evict_fn)
+static a3d_cache_t*
+a3d_cache_create(int max_size, a3d_workqpool_t* pool,
+                 int priority, int weight,
+                 a3d_cacheload_fn  load_fn,
+                 a3d_cachestore_fn store_fn,
+                 a3d_cacheevict_fn evict_fn)
 {
+	// pool may be NULL
 	assert(load_fn);
 	assert(store_fn);
 	assert(evict_fn);
@@ -153,15 +190,27 @@ a3d_cache_t* a3d_cache_new(int max_size,
 	}
 
 	// order lru by last access from oldest (head) to newest (tail)
-	self->lru = a3d_list_new();
+	// the lru links are embedded in the cache nodes
+	self->lru = a3d_list_newIntrusive();
 	if(self->lru == NULL)
 	{
 		goto fail_lru;
 	}
 
-	self->loader = a3d_workq_new(NULL, 1,
-	                             a3d_cache_runfn,
-	                             a3d_cache_purgefn);
+	if(pool)
+	{
+		self->loader = a3d_workq_newShared(NULL, pool,
+		                                   priority, weight,
+		                                   a3d_cache_runfn,
+		                                   a3d_cache_purgefn);
+	}
+	else
+	{
+		self->loader = a3d_workq_new(NULL, 1,
+		                             a3d_cache_runfn,
+		                             a3d_cache_purgefn);
+	}
+
 	if(self->loader == NULL)
 	{
 		goto fail_loader;
@@ -189,6 +238,41 @@ a3d_cache_t* a3d_cache_new(int max_size,
 	return NULL;
 }
 
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+a3d_cache_t* a3d_cache_new(int max_size,
+                           a3d_cacheload_fn  load_fn,
+                           a3d_cachestore_fn store_fn,
+                           a3d_cacheevict_fn evict_fn)
+{
+	assert(load_fn);
+	assert(store_fn);
+	assert(evict_fn);
+
+	return a3d_cache_create(max_size, NULL, 0, 1,
+	                        load_fn, store_fn, evict_fn);
+}
+
+a3d_cache_t* a3d_cache_newShared(int max_size,
+                                 a3d_workqpool_t* pool,
+                                 int priority, int weight,
+                                 a3d_cacheload_fn  load_fn,
+                                 a3d_cachestore_fn store_fn,
+                                 a3d_cacheevict_fn evict_fn)
+{
+	assert(pool);
+	assert(load_fn);
+	assert(store_fn);
+	assert(evict_fn);
+
+	// load items on the shared pool rather than a
+	// dedicated loader thread
+	return a3d_cache_create(max_size, pool, priority, weight,
+	                        load_fn, store_fn, evict_fn);
+}
+
 void a3d_cache_delete(a3d_cache_t** _self)
 {
 	assert(_self);
@@ -247,19 +331,9 @@ a3d_listitem_t* a3d_cache_register(a3d_cache_t* self, void* data)
 		return NULL;
 	}
 
-	a3d_listitem_t* key = a3d_list_append(self->lru, NULL, (const void*) node);
-	if(key == NULL)
-	{
-		goto fail_key;
-	}
-
-	// success
-	return key;
-
-	// failure
-	fail_key:
-		a3d_cachenode_delete(&node);
-	return NULL;
+	a3d_list_appendItem(self->lru, NULL, &node->item,
+	                    (const void*) node);
+	return &node->item;
 }
 
 void a3d_cache_unregister(a3d_cache_t* self,
@@ -269,11 +343,8 @@ void a3d_cache_unregister(a3d_cache_t* self,
 	assert(key);
 	LOGD("debug");
 
-	a3d_workq_cancel(self->loader, (void*) key);
-	a3d_cachenode_t* n = (a3d_cachenode_t*) a3d_list_remove(self->lru, &key);
-	(*self->evict_fn)(n->data);
-	a3d_cachenode_delete(&n);
-	++self->count_evict;
+	a3d_cachenode_t* n = (a3d_cachenode_t*) a3d_list_removeItem(self->lru, key);
+	a3d_cache_evict(self, n);
 }
 
 int a3d_cache_request(a3d_cache_t* self,
@@ -283,7 +354,7 @@ int a3d_cache_request(a3d_cache_t* self,
 	assert(key);
 	LOGD("debug");
 
-	a3d_cachenode_t* n = (a3d_cachenode_t*) a3d_list_peekitem(key);
+	a3d_cachenode_t* n = a3d_list_container(key, a3d_cachenode_t, item);
 	if(n->status == A3D_CACHE_HIT)
 	{
 		++self->count_hit;
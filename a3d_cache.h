@@ -32,6 +32,7 @@
 #define A3D_CACHE_HIT   2
 
 // called by workq thread
+// items may be loaded concurrently by a shared pool
 typedef int (*a3d_cacheload_fn)(void* data);
 
 // called by main thread for request
@@ -42,6 +43,8 @@ typedef int (*a3d_cachestore_fn)(void* data, int* size);
 // automatically unregisters the item and invalidates the key
 // may be called even if the item has not been loaded or
 // stored in the cache
+// deferred to the next purge or delete when the item is
+// evicted while it is being loaded
 typedef void (*a3d_cacheevict_fn)(void* data);
 
 typedef struct
@@ -67,6 +70,14 @@ a3d_cache_t*    a3d_cache_new(int max_size,
                               a3d_cacheload_fn  load_fn,
                               a3d_cachestore_fn store_fn,
                               a3d_cacheevict_fn evict_fn);
+// load_fn may be called concurrently for different items
+// by the threads of the shared pool
+a3d_cache_t*    a3d_cache_newShared(int max_size,
+                                    a3d_workqpool_t* pool,
+                                    int priority, int weight,
+                                    a3d_cacheload_fn  load_fn,
+                                    a3d_cachestore_fn store_fn,
+                                    a3d_cacheevict_fn evict_fn);
 void            a3d_cache_delete(a3d_cache_t** _self);
 void            a3d_cache_purge(a3d_cache_t* self);
 void            a3d_cache_resize(a3d_cache_t* self, int max_size);
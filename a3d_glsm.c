@@ -37,21 +37,9 @@ static void a3d_glsm_draincache(a3d_glsm_t* self)
 	assert(self);
 	LOGD("debug");
 
-	// empty the vb list
-	a3d_vec3f_t* v = (a3d_vec3f_t*) a3d_list_dequeue(self->cache_vb);
-	while(v)
-	{
-		free(v);
-		v = (a3d_vec3f_t*) a3d_list_dequeue(self->cache_vb);
-	}
-
-	// empty the nb list
-	v = (a3d_vec3f_t*) a3d_list_dequeue(self->cache_nb);
-	while(v)
-	{
-		free(v);
-		v = (a3d_vec3f_t*) a3d_list_dequeue(self->cache_nb);
-	}
+	// keep the capacity for the next begin/end
+	a3d_array_clear(self->cache_vb);
+	a3d_array_clear(self->cache_nb);
 }
 
 static void a3d_glsm_freebuffers(a3d_glsm_t* self)
@@ -59,8 +47,7 @@ static void a3d_glsm_freebuffers(a3d_glsm_t* self)
 	assert(self);
 	LOGD("debug");
 
-	free(self->vb);
-	free(self->nb);
+	// vb/nb are owned by the cache arrays
 	self->vb = NULL;
 	self->nb = NULL;
 }
@@ -92,11 +79,11 @@ a3d_glsm_t* a3d_glsm_new(void)
 	self->nb       = NULL;
 	self->status   = A3D_GLSM_INCOMPLETE;
 
-	self->cache_vb = a3d_list_new();
+	self->cache_vb = a3d_array_new(sizeof(a3d_vec3f_t));
 	if(self->cache_vb == NULL)
 		goto fail_cache_vb;
 
-	self->cache_nb = a3d_list_new();
+	self->cache_nb = a3d_array_new(sizeof(a3d_vec3f_t));
 	if(self->cache_nb == NULL)
 		goto fail_cache_nb;
 
@@ -105,7 +92,7 @@ a3d_glsm_t* a3d_glsm_new(void)
 
 	// failure
 	fail_cache_nb:
-		a3d_list_delete(&self->cache_vb);
+		a3d_array_delete(&self->cache_vb);
 	fail_cache_vb:
 		free(self);
 	return NULL;
@@ -121,10 +108,9 @@ void a3d_glsm_delete(a3d_glsm_t** _self)
 	{
 		LOGD("debug");
 
-		a3d_glsm_draincache(self);
-		a3d_list_delete(&self->cache_vb);
-		a3d_list_delete(&self->cache_nb);
 		a3d_glsm_freebuffers(self);
+		a3d_array_delete(&self->cache_vb);
+		a3d_array_delete(&self->cache_nb);
 		free(self);
 		*_self = NULL;
 	}
@@ -163,43 +149,22 @@ void a3d_glsm_vertex3f(a3d_glsm_t* self, float x, float y, float z)
 
 	if(self->status != A3D_GLSM_INCOMPLETE) return;
 
-	a3d_vec3f_t* v = (a3d_vec3f_t*) malloc(sizeof(a3d_vec3f_t));
-	if(v == NULL)
-	{
-		LOGE("malloc failed");
-		goto fail_malloc_v;
-	}
-	v->x = x;
-	v->y = y;
-	v->z = z;
+	a3d_vec3f_t v;
+	v.x = x;
+	v.y = y;
+	v.z = z;
 
-	if(a3d_list_enqueue(self->cache_vb, (const void*) v) == 0)
-		goto fail_append_vb;
-
-	a3d_vec3f_t* n = (a3d_vec3f_t*) malloc(sizeof(a3d_vec3f_t));
-	if(n == NULL)
-	{
-		LOGE("malloc failed");
-		goto fail_malloc_n;
-	}
-	n->x = self->normal.x;
-	n->y = self->normal.y;
-	n->z = self->normal.z;
+	if(a3d_array_push(self->cache_vb, (const void*) &v) == 0)
+		goto fail_push;
 
-	if(a3d_list_enqueue(self->cache_nb, (const void*) n) == 0)
-		goto fail_append_nb;
+	if(a3d_array_push(self->cache_nb, (const void*) &self->normal) == 0)
+		goto fail_push;
 
 	// success
 	return;
 
 	// failure
-	fail_append_nb:
-		free(n);
-	fail_malloc_n:
-		// cache drained below
-	fail_append_vb:
-		free(v);
-	fail_malloc_v:
+	fail_push:
 		a3d_glsm_draincache(self);
 		self->status = A3D_GLSM_ERROR;
 }
@@ -211,54 +176,14 @@ void a3d_glsm_end(a3d_glsm_t* self)
 
 	if(self->status != A3D_GLSM_INCOMPLETE) return;
 
-	// initialize buffers
-	self->ec = a3d_list_size(self->cache_vb);   // vertex count
-	self->vb = (GLfloat*) malloc(3 * self->ec * sizeof(GLfloat));
-	self->nb = (GLfloat*) malloc(3 * self->ec * sizeof(GLfloat));
-	if((self->vb == NULL) || (self->nb == NULL))
-	{
-		LOGE("malloc failed");
-		goto fail_malloc;
-	}
-
-	// replay the cached vertices and normals
-	GLsizei vi;
-	a3d_vec3f_t* v;
-	a3d_vec3f_t* n;
-	for(vi = 0; vi < self->ec; ++vi)
-	{
-		v = (a3d_vec3f_t*) a3d_list_dequeue(self->cache_vb);
-		if(v == NULL)
-			goto fail_vert;
-
-		n = (a3d_vec3f_t*) a3d_list_dequeue(self->cache_nb);
-		if(n == NULL)
-			goto fail_norm;
-	
-		self->vb[3 * vi    ] = v->x;
-		self->vb[3 * vi + 1] = v->y;
-		self->vb[3 * vi + 2] = v->z;
-		self->nb[3 * vi    ] = n->x;
-		self->nb[3 * vi + 1] = n->y;
-		self->nb[3 * vi + 2] = n->z;
-
-		// free the cache as we go
-		free(v);
-		free(n);
-	}
+	// the cached vertices and normals are stored contiguously
+	// so the arrays may be used directly
+	self->ec = a3d_array_size(self->cache_vb);   // vertex count
+	self->vb = (GLfloat*) a3d_array_data(self->cache_vb);
+	self->nb = (GLfloat*) a3d_array_data(self->cache_nb);
 
 	// success
 	self->status = A3D_GLSM_COMPLETE;
-	return;
-
-	// failure
-	fail_norm:
-		free(v);
-	fail_vert:
-		a3d_glsm_freebuffers(self);
-	fail_malloc:
-		a3d_glsm_draincache(self);
-	self->status = A3D_GLSM_ERROR;
 }
 
 int a3d_glsm_status(a3d_glsm_t* self)
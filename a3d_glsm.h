@@ -24,7 +24,7 @@
 #ifndef a3d_glsm_H
 #define a3d_glsm_H
 
-#include "a3d_list.h"
+#include "a3d_array.h"
 #include "math/a3d_vec3f.h"
 #include "a3d_GL.h"
 
@@ -38,10 +38,11 @@ typedef struct
 	// state
 	int status;
 	a3d_vec3f_t normal;
-	a3d_list_t* cache_vb;   // vertex(s)
-	a3d_list_t* cache_nb;   // normal(s)
+	a3d_array_t* cache_vb;   // vertex(s)
+	a3d_array_t* cache_nb;   // normal(s)
 
 	// "completed" arrays
+	// vb/nb reference the cache arrays
 	GLsizei  ec;   // element count
 	GLfloat* vb;   // vertex(s)
 	GLfloat* nb;   // normal(s)
@@ -37,31 +37,28 @@
 ***********************************************************/
 
 static void
-a3d_hashmapIter_init(a3d_hashmapIter_t* self,
-                     a3d_hashmapNode_t* node)
+a3d_hashmapIter_update(a3d_hashmapIter_t* self,
+                       int offset,
+                       a3d_hashmapNode_t* node)
 {
 	assert(self);
 	assert(node);
+	assert((offset + node->len) < A3D_HASHMAP_KEY_LEN);
 
-	self->depth   = 0;
-	self->key[0]  = node->k;
-	self->key[1]  = '\0';
-	self->node[0] = node;
+	memcpy(&self->key[offset], node->k, node->len);
+	self->key[offset + node->len] = '\0';
+	self->node   = node;
+	self->offset = offset;
 }
 
 static void
-a3d_hashmapIter_update(a3d_hashmapIter_t* self,
-                       int d, a3d_hashmapNode_t* node)
+a3d_hashmapIter_init(a3d_hashmapIter_t* self,
+                     a3d_hashmapNode_t* node)
 {
 	assert(self);
-	assert(d >= 0);
-	assert(d < (A3D_HASHMAP_KEY_LEN - 1));
 	assert(node);
 
-	self->depth      = d;
-	self->key[d]     = node->k;
-	self->key[d + 1] = '\0';
-	self->node[d]    = node;
+	a3d_hashmapIter_update(self, 0, node);
 }
 
 /***********************************************************
@@ -70,25 +67,58 @@ a3d_hashmapIter_update(a3d_hashmapIter_t* self,
 
 static a3d_hashmapNode_t*
 a3d_hashmapNode_new(a3d_hashmapNode_t* prev,
-                    a3d_hashmap_t* hash, char k)
+                    a3d_hashmap_t* hash,
+                    const char* k, int len)
 {
 	assert(hash);
+	assert(k);
+	assert(len > 0);
+	assert(len <= A3D_HASHMAP_LABEL_LEN);
 
 	// prev may be NULL for head
 
-	a3d_hashmapNode_t* self = (a3d_hashmapNode_t*)
-	                          malloc(sizeof(a3d_hashmapNode_t));
-	if(self == NULL)
+	// recycle a free node
+	a3d_hashmapNode_t* self = hash->free_head;
+	if(self)
 	{
-		LOGE("malloc failed");
-		return NULL;
+		hash->free_head = self->next;
+	}
+	else
+	{
+		// allocate a new chunk when the current chunk is full
+		if((hash->chunk_head == NULL) ||
+		   (hash->chunk_used == A3D_HASHMAP_CHUNK_SIZE))
+		{
+			a3d_hashmapChunk_t* chunk;
+			chunk = (a3d_hashmapChunk_t*)
+			        malloc(sizeof(a3d_hashmapChunk_t) +
+			               A3D_HASHMAP_CHUNK_SIZE*
+			               sizeof(a3d_hashmapNode_t));
+			if(chunk == NULL)
+			{
+				LOGE("malloc failed");
+				return NULL;
+			}
+
+			chunk->next      = hash->chunk_head;
+			hash->chunk_head = chunk;
+			hash->chunk_used = 0;
+			++hash->chunks;
+		}
+
+		// carve the node from the current chunk
+		a3d_hashmapNode_t* nodes;
+		nodes = (a3d_hashmapNode_t*) &hash->chunk_head[1];
+		self  = &nodes[hash->chunk_used];
+		++hash->chunk_used;
 	}
 
 	self->prev = prev;
 	self->next = NULL;
 	self->down = NULL;
 	self->val  = NULL;
-	self->k    = k;
+	self->len  = (unsigned char) len;
+	memcpy(self->k, k, len);
 
 	++hash->nodes;
 
@@ -102,22 +132,209 @@ a3d_hashmapNode_delete(a3d_hashmapNode_t** _self,
 	assert(_self);
 	assert(hash);
 
+	// only detached nodes are deleted since the chunks
+	// are freed by a3d_hashmap_trieDiscard
 	a3d_hashmapNode_t* self = *_self;
 	if(self)
 	{
+		assert(self->next == NULL);
+		assert(self->down == NULL);
+
 		// prev is a reference
 		--hash->nodes;
-		a3d_hashmapNode_delete(&self->next, hash);
-		a3d_hashmapNode_delete(&self->down, hash);
-		free(self);
+		self->prev      = NULL;
+		self->next      = hash->free_head;
+		self->val       = NULL;
+		hash->free_head = self;
 		*_self = NULL;
 	}
 }
 
+static a3d_hashmapNode_t*
+a3d_hashmapNode_parent(a3d_hashmapNode_t* self)
+{
+	assert(self);
+
+	// prev is the parent for the first node in a
+	// sibling chain
+	while(self->prev && (self->prev->next == self))
+	{
+		self = self->prev;
+	}
+	return self->prev;
+}
+
+static a3d_hashmapNode_t*
+a3d_hashmapNode_newChain(a3d_hashmapNode_t* prev,
+                         a3d_hashmap_t* hash,
+                         const void* val,
+                         const char* k, int len)
+{
+	assert(hash);
+	assert(val);
+	assert(k);
+	assert(len > 0);
+
+	// store the key suffix in a chain of single child
+	// nodes since labels are limited in length
+	a3d_hashmapNode_t* head = NULL;
+	a3d_hashmapNode_t* node = NULL;
+	while(len > 0)
+	{
+		int n = len;
+		if(n > A3D_HASHMAP_LABEL_LEN)
+		{
+			n = A3D_HASHMAP_LABEL_LEN;
+		}
+
+		a3d_hashmapNode_t* down;
+		down = a3d_hashmapNode_new(node ? node : prev,
+		                           hash, k, n);
+		if(down == NULL)
+		{
+			while(head)
+			{
+				node = head;
+				head = head->down;
+				node->down = NULL;
+				a3d_hashmapNode_delete(&node, hash);
+			}
+			return NULL;
+		}
+
+		if(node)
+		{
+			node->down = down;
+		}
+		else
+		{
+			head = down;
+		}
+		node = down;
+
+		k   += n;
+		len -= n;
+	}
+	node->val = val;
+
+	return head;
+}
+
+static int
+a3d_hashmapNode_split(a3d_hashmapNode_t* self,
+                      a3d_hashmap_t* hash, int n)
+{
+	assert(self);
+	assert(hash);
+	assert(n > 0);
+	assert(n < self->len);
+
+	// move the label suffix, val and children
+	// into a new down node
+	a3d_hashmapNode_t* down;
+	down = a3d_hashmapNode_new(self, hash, &self->k[n],
+	                           self->len - n);
+	if(down == NULL)
+	{
+		return 0;
+	}
+
+	down->val  = self->val;
+	down->down = self->down;
+	if(down->down)
+	{
+		down->down->prev = down;
+	}
+
+	self->down = down;
+	self->val  = NULL;
+	self->len  = (unsigned char) n;
+
+	return 1;
+}
+
+static void
+a3d_hashmapNode_merge(a3d_hashmapNode_t* self,
+                      a3d_hashmap_t* hash);
+
+static void
+a3d_hashmapNode_shift(a3d_hashmapNode_t* self,
+                      a3d_hashmap_t* hash, int n)
+{
+	assert(self);
+	assert(hash);
+	assert(self->prev);
+	assert(self->prev->down == self);
+	assert(n > 0);
+	assert(n < self->len);
+
+	// move the label prefix into the parent which avoids
+	// a split when the parent has a single down node
+	a3d_hashmapNode_t* parent = self->prev;
+	assert((parent->len + n) <= A3D_HASHMAP_LABEL_LEN);
+	memcpy(&parent->k[parent->len], self->k, n);
+	parent->len += n;
+	self->len   -= n;
+	memmove(self->k, &self->k[n], self->len);
+
+	// the shorter label may fit its single down node
+	a3d_hashmapNode_merge(self, hash);
+}
+
+static void
+a3d_hashmapNode_merge(a3d_hashmapNode_t* self,
+                      a3d_hashmap_t* hash)
+{
+	assert(self);
+	assert(hash);
+
+	// absorb a single down node when the label fits
+	a3d_hashmapNode_t* down = self->down;
+	if((self->val  != NULL) ||
+	   (down       == NULL) ||
+	   (down->next != NULL) ||
+	   ((self->len + down->len) > A3D_HASHMAP_LABEL_LEN))
+	{
+		return;
+	}
+
+	memcpy(&self->k[self->len], down->k, down->len);
+	self->len += down->len;
+	self->val  = down->val;
+	self->down = down->down;
+	if(self->down)
+	{
+		self->down->prev = self;
+	}
+
+	down->down = NULL;
+	a3d_hashmapNode_delete(&down, hash);
+}
+
 /***********************************************************
-* private hashmap                                          *
+* private - hashmap trie                                   *
 ***********************************************************/
 
+static void
+a3d_hashmap_trieDiscard(a3d_hashmap_t* self)
+{
+	assert(self);
+
+	// free the chunks rather than walking the trie
+	while(self->chunk_head)
+	{
+		a3d_hashmapChunk_t* chunk = self->chunk_head;
+		self->chunk_head = chunk->next;
+		free(chunk);
+	}
+
+	self->head       = NULL;
+	self->nodes      = 0;
+	self->chunks     = 0;
+	self->chunk_used = 0;
+	self->free_head  = NULL;
+}
+
 static void
 a3d_hashmap_clean(a3d_hashmap_t* self,
                   a3d_hashmapNode_t* node)
@@ -126,14 +343,20 @@ a3d_hashmap_clean(a3d_hashmap_t* self,
 	assert(node);
 
 	// check if the node is an endpoint or traversal node
-	if(node->val || node->down)
+	if(node->val)
 	{
 		return;
 	}
+	else if(node->down)
+	{
+		a3d_hashmapNode_merge(node, self);
+		return;
+	}
 
 	// detach empty nodes
-	a3d_hashmapNode_t* prev = node->prev;
-	a3d_hashmapNode_t* next = node->next;
+	a3d_hashmapNode_t* prev   = node->prev;
+	a3d_hashmapNode_t* next   = node->next;
+	a3d_hashmapNode_t* parent = NULL;
 	if(prev == NULL)
 	{
 		self->head = next;
@@ -141,11 +364,12 @@ a3d_hashmap_clean(a3d_hashmap_t* self,
 	else if(prev->down == node)
 	{
 		prev->down = next;
-		a3d_hashmap_clean(self, prev);
+		parent     = prev;
 	}
 	else
 	{
 		prev->next = next;
+		parent     = a3d_hashmapNode_parent(prev);
 	}
 
 	if(next)
@@ -153,14 +377,834 @@ a3d_hashmap_clean(a3d_hashmap_t* self,
 		next->prev = prev;
 	}
 
-	node->prev = NULL;
-	node->next = NULL;
-	a3d_hashmapNode_delete(&node, self);
+	node->prev = NULL;
+	node->next = NULL;
+	a3d_hashmapNode_delete(&node, self);
+
+	// the parent may now be empty or have a single
+	// down node
+	if(parent)
+	{
+		a3d_hashmap_clean(self, parent);
+	}
+}
+
+static int
+a3d_hashmap_compare(const char* a, const char* b)
+{
+	assert(a);
+	assert(b);
+
+	// compare keys in trie order
+	while(*a && (*a == *b))
+	{
+		++a;
+		++b;
+	}
+	return (int) *a - (int) *b;
+}
+
+static a3d_hashmapIter_t*
+a3d_hashmap_trieStep(a3d_hashmapIter_t* iter, int down)
+{
+	assert(iter);
+
+	// move to the next node in key order which may
+	// skip the down nodes and may not leave the prefix
+	int offset = iter->offset;
+	a3d_hashmapNode_t* node = iter->node;
+	if(down && node->down)
+	{
+		// down
+		offset += node->len;
+		node = node->down;
+		a3d_hashmapIter_update(iter, offset, node);
+	}
+	else if(node->next && (offset >= iter->prefix))
+	{
+		// sideways
+		node = node->next;
+		a3d_hashmapIter_update(iter, offset, node);
+	}
+	else
+	{
+		// up
+		while(1)
+		{
+			node = a3d_hashmapNode_parent(node);
+			if(node == NULL)
+			{
+				return NULL;
+			}
+
+			offset -= node->len;
+			if(offset < iter->prefix)
+			{
+				return NULL;
+			}
+			else if(node->next)
+			{
+				node = node->next;
+				a3d_hashmapIter_update(iter, offset, node);
+				break;
+			}
+		}
+	}
+
+	return iter;
+}
+
+static a3d_hashmapIter_t*
+a3d_hashmap_trieEndpoint(a3d_hashmapIter_t* iter)
+{
+	// iter may be NULL
+
+	// find an endpoint
+	while(iter)
+	{
+		a3d_hashmapNode_t* node = iter->node;
+		if(node->val)
+		{
+			// keys are ordered so the remaining keys
+			// also exceed the upper bound
+			if(iter->upper &&
+			   (a3d_hashmap_compare(iter->key, iter->upper) >= 0))
+			{
+				return NULL;
+			}
+			return iter;
+		}
+
+		iter = a3d_hashmap_trieStep(iter, 1);
+	}
+
+	return NULL;
+}
+
+static a3d_hashmapIter_t*
+a3d_hashmap_trieHead(const a3d_hashmap_t* self,
+                     a3d_hashmapIter_t* iter)
+{
+	assert(self);
+	assert(iter);
+
+	if(self->head == NULL)
+	{
+		return NULL;
+	}
+
+	a3d_hashmapIter_init(iter, self->head);
+
+	return a3d_hashmap_trieEndpoint(iter);
+}
+
+static a3d_hashmapIter_t*
+a3d_hashmap_trieNext(a3d_hashmapIter_t* iter)
+{
+	assert(iter);
+
+	iter = a3d_hashmap_trieStep(iter, 1);
+	return a3d_hashmap_trieEndpoint(iter);
+}
+
+static a3d_hashmapIter_t*
+a3d_hashmap_triePrefix(const a3d_hashmap_t* self,
+                       a3d_hashmapIter_t* iter,
+                       const char* prefix, int len)
+{
+	assert(self);
+	assert(iter);
+	assert(prefix);
+
+	// traverse to the first node which covers the prefix
+	int offset = 0;
+	a3d_hashmapNode_t* node = self->head;
+	while(node)
+	{
+		// siblings are sorted by the first label char
+		while(node && (node->k[0] < prefix[offset]))
+		{
+			node = node->next;
+		}
+
+		if((node == NULL) || (node->k[0] != prefix[offset]))
+		{
+			// not found
+			return NULL;
+		}
+
+		// the prefix may end within the label
+		int n = len - offset;
+		if(n > node->len)
+		{
+			n = node->len;
+		}
+
+		if(memcmp(node->k, &prefix[offset], n) != 0)
+		{
+			// not found
+			return NULL;
+		}
+
+		a3d_hashmapIter_update(iter, offset, node);
+		offset += node->len;
+		if(offset >= len)
+		{
+			// iterate the subtree
+			iter->prefix = len;
+			return a3d_hashmap_trieEndpoint(iter);
+		}
+
+		// down
+		node = node->down;
+	}
+
+	return NULL;
+}
+
+static a3d_hashmapIter_t*
+a3d_hashmap_trieLower(const a3d_hashmap_t* self,
+                      a3d_hashmapIter_t* iter,
+                      const char* lower)
+{
+	assert(self);
+	assert(iter);
+	assert(lower);
+
+	// traverse to the first key greater than or equal
+	// to the lower bound
+	int offset = 0;
+	a3d_hashmapNode_t* node = self->head;
+	while(node)
+	{
+		while(node->next && (node->next->k[0] <= lower[offset]))
+		{
+			node = node->next;
+		}
+		a3d_hashmapIter_update(iter, offset, node);
+
+		// compare the label with the lower bound
+		int i = 0;
+		while((i < node->len) && (lower[offset + i] != '\0') &&
+		      (node->k[i] == lower[offset + i]))
+		{
+			++i;
+		}
+
+		if(i == node->len)
+		{
+			offset += node->len;
+			if(lower[offset] == '\0')
+			{
+				// the node key equals the lower bound
+				return a3d_hashmap_trieEndpoint(iter);
+			}
+			else if(node->down == NULL)
+			{
+				break;
+			}
+
+			// down
+			node = node->down;
+			continue;
+		}
+		else if((lower[offset + i] == '\0') ||
+		        (node->k[i] > lower[offset + i]))
+		{
+			// the subtree keys are greater
+			return a3d_hashmap_trieEndpoint(iter);
+		}
+
+		break;
+	}
+
+	// the subtree keys are less so skip the subtree
+	if(node)
+	{
+		iter = a3d_hashmap_trieStep(iter, 0);
+		return a3d_hashmap_trieEndpoint(iter);
+	}
+
+	return NULL;
+}
+
+static const void*
+a3d_hashmap_trieFind(const a3d_hashmap_t* self,
+                     a3d_hashmapIter_t* iter,
+                     const char* key, int len)
+{
+	assert(self);
+	assert(iter);
+	assert(key);
+
+	// traverse the hashmap
+	int offset = 0;
+	a3d_hashmapNode_t* node = self->head;
+	while(node)
+	{
+		// siblings are sorted by the first label char
+		while(node && (node->k[0] < key[offset]))
+		{
+			node = node->next;
+		}
+
+		if((node == NULL) || (node->k[0] != key[offset]) ||
+		   (node->len > (len - offset)) ||
+		   (memcmp(node->k, &key[offset], node->len) != 0))
+		{
+			// not found
+			return NULL;
+		}
+
+		a3d_hashmapIter_update(iter, offset, node);
+		offset += node->len;
+		if(offset == len)
+		{
+			// success
+			return node->val;
+		}
+
+		// down
+		node = node->down;
+	}
+
+	return NULL;
+}
+
+static int
+a3d_hashmap_trieAdd(a3d_hashmap_t* self,
+                    const void* val,
+                    const char* key, int len)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	// traverse the hashmap
+	// prev is the parent or sibling for a new node and
+	// link is the pointer to update
+	int offset = 0;
+	a3d_hashmapNode_t*  prev  = NULL;
+	a3d_hashmapNode_t*  split = NULL;
+	a3d_hashmapNode_t** link  = &self->head;
+	while(1)
+	{
+		// siblings are sorted by the first label char
+		a3d_hashmapNode_t* node = *link;
+		while(node && (node->k[0] < key[offset]))
+		{
+			prev = node;
+			link = &node->next;
+			node = node->next;
+		}
+
+		if((node == NULL) || (node->k[0] != key[offset]))
+		{
+			// insert the key suffix before node
+			a3d_hashmapNode_t* chain;
+			chain = a3d_hashmapNode_newChain(prev, self, val,
+			                                 &key[offset],
+			                                 len - offset);
+			if(chain == NULL)
+			{
+				goto fail_add;
+			}
+
+			chain->next = node;
+			if(node)
+			{
+				node->prev = chain;
+			}
+			*link = chain;
+
+			// success
+			++self->size;
+			return 1;
+		}
+
+		// match the label
+		int n = 1;
+		while((n < node->len) && (offset + n < len) &&
+		      (node->k[n] == key[offset + n]))
+		{
+			++n;
+		}
+
+		// split the label on a partial match
+		// which moves the values of existing keys
+		if(n < node->len)
+		{
+			++self->generation;
+			if(prev && (prev->down == node) &&
+			   (prev->val  == NULL) && (node->next == NULL) &&
+			   ((prev->len + n) <= A3D_HASHMAP_LABEL_LEN))
+			{
+				a3d_hashmapNode_shift(node, self, n);
+				node = prev;
+			}
+			else
+			{
+				if(a3d_hashmapNode_split(node, self, n) == 0)
+				{
+					return 0;
+				}
+				split = node;
+
+				// the suffix may fit its single down node
+				a3d_hashmapNode_merge(node->down, self);
+			}
+		}
+
+		offset += n;
+		if(offset == len)
+		{
+			if(node->val)
+			{
+				// hash already contains key
+				return 0;
+			}
+
+			// success
+			++self->size;
+			node->val = val;
+			return 1;
+		}
+
+		// down
+		prev = node;
+		link = &node->down;
+	}
+
+	// failure
+	fail_add:
+		if(split)
+		{
+			a3d_hashmapNode_merge(split, self);
+		}
+	return 0;
+}
+
+static const void*
+a3d_hashmap_trieRemove(a3d_hashmap_t* self,
+                       a3d_hashmapIter_t** _iter)
+{
+	assert(self);
+	assert(_iter);
+	assert(*_iter);
+
+	a3d_hashmapIter_t* iter = *_iter;
+
+	// save node and update iter
+	a3d_hashmapNode_t* node = iter->node;
+	*_iter = a3d_hashmap_trieNext(iter);
+
+	// clear value and clean traversal nodes
+	const void* val = node->val;
+	node->val = NULL;
+	a3d_hashmap_clean(self, node);
+
+	--self->size;
+	++self->generation;
+
+	// cleaning may merge nodes on the path of the next
+	// key so the iter must be rebuilt
+	if(*_iter)
+	{
+		int         prefix = iter->prefix;
+		const char* upper  = iter->upper;
+
+		char key[A3D_HASHMAP_KEY_LEN];
+		snprintf(key, A3D_HASHMAP_KEY_LEN, "%s", iter->key);
+		a3d_hashmap_trieFind(self, iter, key, strlen(key));
+
+		iter->prefix = prefix;
+		iter->upper  = upper;
+	}
+
+	return val;
+}
+
+/***********************************************************
+* private - hashmap table                                  *
+***********************************************************/
+
+// reserved slot hashes
+#define A3D_HASHMAP_SLOT_EMPTY   0
+#define A3D_HASHMAP_SLOT_DELETED 1
+
+// the capacity is a power of two
+#define A3D_HASHMAP_MIN_CAPACITY 16
+
+static unsigned int
+a3d_hashmap_hash(const char* key, int len)
+{
+	assert(key);
+
+	// FNV-1a
+	int          i;
+	unsigned int h = 2166136261U;
+	for(i = 0; i < len; ++i)
+	{
+		h ^= (unsigned char) key[i];
+		h *= 16777619U;
+	}
+
+	// mix the high bits into the low bits which
+	// select the slot
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+
+	// reserve the empty and deleted hashes
+	return (h <= A3D_HASHMAP_SLOT_DELETED) ? (h + 2) : h;
+}
+
+static int
+a3d_hashmap_probe(const a3d_hashmap_t* self,
+                  const char* key, int len,
+                  unsigned int hash, int* _insert)
+{
+	// _insert may be NULL
+	assert(self);
+	assert(key);
+	assert(self->capacity > 0);
+
+	// linear probing where the cached hash avoids most of
+	// the key comparisons and the load factor ensures an
+	// empty slot always terminates the probe
+	int mask   = self->capacity - 1;
+	int idx    = (int) (hash & mask);
+	int insert = -1;
+	while(1)
+	{
+		a3d_hashmapSlot_t* slot = &self->slots[idx];
+		if(slot->hash == A3D_HASHMAP_SLOT_EMPTY)
+		{
+			if(insert < 0)
+			{
+				insert = idx;
+			}
+			break;
+		}
+		else if(slot->hash == A3D_HASHMAP_SLOT_DELETED)
+		{
+			if(insert < 0)
+			{
+				insert = idx;
+			}
+		}
+		else if((slot->hash == hash) &&
+		        (strncmp(slot->key, key, len) == 0) &&
+		        (slot->key[len] == '\0'))
+		{
+			return idx;
+		}
+
+		idx = (idx + 1) & mask;
+	}
+
+	if(_insert)
+	{
+		*_insert = insert;
+	}
+	return -1;
+}
+
+static int
+a3d_hashmap_rehash(a3d_hashmap_t* self, int capacity)
+{
+	assert(self);
+	assert(capacity >= A3D_HASHMAP_MIN_CAPACITY);
+
+	a3d_hashmapSlot_t* slots = (a3d_hashmapSlot_t*)
+	                           calloc(capacity,
+	                                  sizeof(a3d_hashmapSlot_t));
+	if(slots == NULL)
+	{
+		LOGE("calloc failed");
+		return 0;
+	}
+
+	// reinsert the keys which drops the deleted slots
+	int mask = capacity - 1;
+	int i;
+	for(i = 0; i < self->capacity; ++i)
+	{
+		a3d_hashmapSlot_t* slot = &self->slots[i];
+		if(slot->hash <= A3D_HASHMAP_SLOT_DELETED)
+		{
+			continue;
+		}
+
+		int idx = (int) (slot->hash & mask);
+		while(slots[idx].hash != A3D_HASHMAP_SLOT_EMPTY)
+		{
+			idx = (idx + 1) & mask;
+		}
+		slots[idx] = *slot;
+	}
+
+	free(self->slots);
+	self->slots    = slots;
+	self->capacity = capacity;
+	self->deleted  = 0;
+	++self->generation;
+
+	return 1;
+}
+
+static void
+a3d_hashmap_tableDiscard(a3d_hashmap_t* self)
+{
+	assert(self);
+
+	int i;
+	for(i = 0; i < self->capacity; ++i)
+	{
+		a3d_hashmapSlot_t* slot = &self->slots[i];
+		if(slot->hash > A3D_HASHMAP_SLOT_DELETED)
+		{
+			free(slot->key);
+		}
+		slot->hash = A3D_HASHMAP_SLOT_EMPTY;
+		slot->key  = NULL;
+		slot->val  = NULL;
+	}
+	self->deleted = 0;
+}
+
+static a3d_hashmapIter_t*
+a3d_hashmap_tableNext(a3d_hashmapIter_t* iter, int idx)
+{
+	assert(iter);
+
+	// find the next occupied slot starting from idx
+	const a3d_hashmap_t* self = iter->hashmap;
+	while(idx < self->capacity)
+	{
+		if(self->slots[idx].hash > A3D_HASHMAP_SLOT_DELETED)
+		{
+			iter->index = idx;
+			return iter;
+		}
+		++idx;
+	}
+
+	return NULL;
+}
+
+static const void*
+a3d_hashmap_tableFind(const a3d_hashmap_t* self,
+                      a3d_hashmapIter_t* iter,
+                      const char* key, int len,
+                      unsigned int hash)
+{
+	assert(self);
+	assert(iter);
+	assert(key);
+
+	if(self->size == 0)
+	{
+		return NULL;
+	}
+
+	int idx = a3d_hashmap_probe(self, key, len, hash, NULL);
+	if(idx < 0)
+	{
+		return NULL;
+	}
+
+	iter->hashmap = self;
+	iter->index   = idx;
+	return self->slots[idx].val;
+}
+
+static int
+a3d_hashmap_tableAdd(a3d_hashmap_t* self,
+                     const void* val,
+                     const char* key, int len,
+                     unsigned int hash)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	// grow the table or drop deleted slots to keep the
+	// load factor below 3/4
+	if((self->size + self->deleted + 1)*4 > 3*self->capacity)
+	{
+		int capacity = self->capacity;
+		if(capacity < A3D_HASHMAP_MIN_CAPACITY)
+		{
+			capacity = A3D_HASHMAP_MIN_CAPACITY;
+		}
+
+		while((self->size + 1)*2 > capacity)
+		{
+			capacity *= 2;
+		}
+
+		if(a3d_hashmap_rehash(self, capacity) == 0)
+		{
+			return 0;
+		}
+	}
+
+	int insert = -1;
+	if(a3d_hashmap_probe(self, key, len, hash, &insert) >= 0)
+	{
+		// hash already contains key
+		return 0;
+	}
+
+	char* copy = (char*) malloc(len + 1);
+	if(copy == NULL)
+	{
+		LOGE("malloc failed");
+		return 0;
+	}
+	memcpy(copy, key, len);
+	copy[len] = '\0';
+
+	a3d_hashmapSlot_t* slot = &self->slots[insert];
+	if(slot->hash == A3D_HASHMAP_SLOT_DELETED)
+	{
+		--self->deleted;
+	}
+	slot->hash = hash;
+	slot->key  = copy;
+	slot->val  = val;
+	++self->size;
+
+	return 1;
+}
+
+static const void*
+a3d_hashmap_tableRemove(a3d_hashmap_t* self,
+                        a3d_hashmapIter_t** _iter)
+{
+	assert(self);
+	assert(_iter);
+	assert(*_iter);
+
+	a3d_hashmapIter_t* iter = *_iter;
+
+	// save slot and update iter
+	// deleted slots are kept so that the remaining
+	// slots do not move while iterating
+	a3d_hashmapSlot_t* slot = &self->slots[iter->index];
+	*_iter = a3d_hashmap_tableNext(iter, iter->index + 1);
+
+	const void* val = slot->val;
+	free(slot->key);
+	slot->hash = A3D_HASHMAP_SLOT_DELETED;
+	slot->key  = NULL;
+	slot->val  = NULL;
+	++self->deleted;
+	--self->size;
+	++self->generation;
+
+	return val;
+}
+
+static int
+a3d_hashmap_validate(const char* key, int len)
+{
+	assert(key);
+
+	// keys may not contain null characters
+	if((len >= A3D_HASHMAP_KEY_LEN) || (len <= 0) ||
+	   memchr(key, '\0', len))
+	{
+		LOGE("invalid len=%i", len);
+		return 0;
+	}
+
+	return 1;
+}
+
+static const void*
+a3d_hashmap_findHash(const a3d_hashmap_t* self,
+                     a3d_hashmapIter_t* iter,
+                     const char* key, int len,
+                     unsigned int hash)
+{
+	assert(self);
+	assert(iter);
+	assert(key);
+
+	iter->hashmap = self;
+	iter->prefix  = 0;
+	iter->upper   = NULL;
+	if(self->ordered)
+	{
+		return a3d_hashmap_trieFind(self, iter, key, len);
+	}
+
+	return a3d_hashmap_tableFind(self, iter, key, len, hash);
+}
+
+static int
+a3d_hashmap_addHash(a3d_hashmap_t* self,
+                    const void* val,
+                    const char* key, int len,
+                    unsigned int hash)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	if(self->ordered)
+	{
+		return a3d_hashmap_trieAdd(self, val, key, len);
+	}
+
+	return a3d_hashmap_tableAdd(self, val, key, len, hash);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int a3d_hashmapKey_init(a3d_hashmapKey_t* self,
+                        const char* key, int len)
+{
+	assert(self);
+	assert(key);
+
+	if(a3d_hashmap_validate(key, len) == 0)
+	{
+		return 0;
+	}
+
+	memcpy(self->key, key, len);
+	self->key[len]   = '\0';
+	self->len        = len;
+	self->hash       = a3d_hashmap_hash(key, len);
+	self->hashmap    = NULL;
+	self->generation = 0;
+	self->index      = -1;
+	self->node       = NULL;
+
+	return 1;
 }
 
-/***********************************************************
-* public                                                   *
-***********************************************************/
+int a3d_hashmapKey_initf(a3d_hashmapKey_t* self,
+                         const char* fmt, ...)
+{
+	assert(self);
+	assert(fmt);
+
+	char key[A3D_HASHMAP_KEY_LEN];
+	va_list argptr;
+	va_start(argptr, fmt);
+	vsnprintf(key, A3D_HASHMAP_KEY_LEN, fmt, argptr);
+	va_end(argptr);
+
+	return a3d_hashmapKey_init(self, key, strlen(key));
+}
 
 a3d_hashmap_t* a3d_hashmap_new(void)
 {
@@ -172,9 +1216,33 @@ a3d_hashmap_t* a3d_hashmap_new(void)
 		return NULL;
 	}
 
-	self->size  = 0;
-	self->nodes = 0;
-	self->head  = NULL;
+	self->size       = 0;
+	self->nodes      = 0;
+	self->generation = 0;
+	self->ordered    = 0;
+	self->head       = NULL;
+	self->chunks     = 0;
+	self->chunk_used = 0;
+	self->chunk_head = NULL;
+	self->free_head  = NULL;
+	self->capacity   = 0;
+	self->deleted    = 0;
+	self->slots      = NULL;
+
+	return self;
+}
+
+a3d_hashmap_t* a3d_hashmap_newOrdered(void)
+{
+	// ordered hashmaps store keys in a trie which
+	// iterates keys in sorted order
+	a3d_hashmap_t* self = a3d_hashmap_new();
+	if(self == NULL)
+	{
+		return NULL;
+	}
+
+	self->ordered = 1;
 
 	return self;
 }
@@ -191,7 +1259,9 @@ void a3d_hashmap_delete(a3d_hashmap_t** _self)
 			LOGE("memory leak detected: size=%i", self->size);
 		}
 
-		a3d_hashmapNode_delete(&self->head, self);
+		a3d_hashmap_trieDiscard(self);
+		a3d_hashmap_tableDiscard(self);
+		free(self->slots);
 		free(self);
 		*_self = NULL;
 	}
@@ -202,7 +1272,9 @@ void a3d_hashmap_discard(a3d_hashmap_t* self)
 	assert(self);
 
 	self->size = 0;
-	a3d_hashmapNode_delete(&self->head, self);
+	++self->generation;
+	a3d_hashmap_trieDiscard(self);
+	a3d_hashmap_tableDiscard(self);
 }
 
 int a3d_hashmap_size(const a3d_hashmap_t* self)
@@ -216,14 +1288,22 @@ int a3d_hashmap_hashmapNodes(const a3d_hashmap_t* self)
 {
 	assert(self);
 
-	return self->nodes;
+	if(self->ordered)
+	{
+		return self->nodes;
+	}
+	return self->capacity;
 }
 
 int a3d_hashmap_hashmapSize(const a3d_hashmap_t* self)
 {
 	assert(self);
 
-	return (int) self->nodes*sizeof(a3d_hashmapNode_t);
+	if(self->ordered)
+	{
+		return (int) self->nodes*sizeof(a3d_hashmapNode_t);
+	}
+	return (int) self->capacity*sizeof(a3d_hashmapSlot_t);
 }
 
 int a3d_hashmap_empty(const a3d_hashmap_t* self)
@@ -240,83 +1320,52 @@ a3d_hashmap_head(const a3d_hashmap_t* self,
 	assert(self);
 	assert(iter);
 
-	if(self->head == NULL)
+	iter->hashmap = self;
+	iter->prefix  = 0;
+	iter->upper   = NULL;
+	if(self->ordered)
 	{
-		return NULL;
+		return a3d_hashmap_trieHead(self, iter);
 	}
 
-	a3d_hashmapIter_init(iter, self->head);
-
-	// find an endpoint
-	if(self->head->val)
-	{
-		return iter;
-	}
-	return a3d_hashmap_next(iter);
+	return a3d_hashmap_tableNext(iter, 0);
 }
 
 a3d_hashmapIter_t* a3d_hashmap_next(a3d_hashmapIter_t* iter)
 {
 	assert(iter);
 
-	int d = iter->depth;
-	a3d_hashmapNode_t* node = iter->node[d];
-	if(node->down)
-	{
-		// down
-		++d;
-		node = node->down;
-		a3d_hashmapIter_update(iter, d, node);
-	}
-	else if(node->next)
-	{
-		// sideways
-		node = node->next;
-		a3d_hashmapIter_update(iter, d, node);
-	}
-	else
+	if(iter->hashmap->ordered)
 	{
-		// up
-		while(1)
-		{
-			--d;
-			if(d < 0)
-			{
-				return NULL;
-			}
-
-			node = iter->node[d];
-			if(node->next)
-			{
-				node = node->next;
-				a3d_hashmapIter_update(iter, d, node);
-				break;
-			}
-		}
+		return a3d_hashmap_trieNext(iter);
 	}
 
-	// find an endpoint
-	if(node->val)
-	{
-		return iter;
-	}
-	return a3d_hashmap_next(iter);
+	return a3d_hashmap_tableNext(iter, iter->index + 1);
 }
 
 const void* a3d_hashmap_val(const a3d_hashmapIter_t* iter)
 {
 	assert(iter);
 
-	int d = iter->depth;
-	a3d_hashmapNode_t* node = iter->node[d];
-	return node->val;
+	if(iter->hashmap->ordered)
+	{
+		a3d_hashmapNode_t* node = iter->node;
+		return node->val;
+	}
+
+	return iter->hashmap->slots[iter->index].val;
 }
 
 const char* a3d_hashmap_key(const a3d_hashmapIter_t* iter)
 {
 	assert(iter);
 
-	return iter->key;
+	if(iter->hashmap->ordered)
+	{
+		return iter->key;
+	}
+
+	return iter->hashmap->slots[iter->index].key;
 }
 
 const void* a3d_hashmap_find(const a3d_hashmap_t* self,
@@ -334,54 +1383,13 @@ const void* a3d_hashmap_find(const a3d_hashmap_t* self,
 		return NULL;
 	}
 
-	// check for empty hashmap
-	if(self->head == NULL)
-	{
-		return NULL;
-	}
-
-	a3d_hashmapIter_init(iter, self->head);
-
-	// traverse the hashmap
-	int d = 0;
-	a3d_hashmapNode_t* node = self->head;
-	while(d < len)
+	unsigned int hash = 0;
+	if(self->ordered == 0)
 	{
-		if(key[d] == iter->key[d])
-		{
-			if(d == (len - 1))
-			{
-				// success
-				return node->val;
-			}
-			else if(node->down)
-			{
-				// down
-				++d;
-				node = node->down;
-				a3d_hashmapIter_update(iter, d, node);
-				continue;
-			}
-
-			return NULL;
-		}
-		else if((key[d] < iter->key[d]) ||
-		        (node->next == NULL))
-		{
-			// not found
-			return NULL;
-		}
-
-		// traverse to the next decision point
-		while(node->next && (key[d] > iter->key[d]))
-		{
-			// sideways
-			node = node->next;
-			a3d_hashmapIter_update(iter, d, node);
-		}
+		hash = a3d_hashmap_hash(key, len);
 	}
 
-	return NULL;
+	return a3d_hashmap_findHash(self, iter, key, len, hash);
 }
 
 const void* a3d_hashmap_findf(const a3d_hashmap_t* self,
@@ -401,146 +1409,162 @@ const void* a3d_hashmap_findf(const a3d_hashmap_t* self,
 	return a3d_hashmap_find(self, iter, key);
 }
 
-int a3d_hashmap_add(a3d_hashmap_t* self,
-                    const void* val,
-                    const char* key)
+const void* a3d_hashmap_findn(const a3d_hashmap_t* self,
+                              a3d_hashmapIter_t* iter,
+                              const char* key, int len)
 {
 	assert(self);
-	assert(val);
+	assert(iter);
 	assert(key);
 
-	int len = strlen(key);
-	if((len >= A3D_HASHMAP_KEY_LEN) || (len == 0))
+	if(a3d_hashmap_validate(key, len) == 0)
 	{
-		LOGE("invalid key=%s, len=%i", key, len);
-		return 0;
+		return NULL;
 	}
 
-	int created = 0;
-	if(self->head == NULL)
+	unsigned int hash = 0;
+	if(self->ordered == 0)
 	{
-		self->head = a3d_hashmapNode_new(NULL, self, key[0]);
-		if(self->head == NULL)
-		{
-			return 0;
-		}
-
-		created = 1;
+		hash = a3d_hashmap_hash(key, len);
 	}
 
-	a3d_hashmapIter_t  iterator;
-	a3d_hashmapIter_t* iter = &iterator;
-	a3d_hashmapIter_init(&iterator, self->head);
+	return a3d_hashmap_findHash(self, iter, key, len, hash);
+}
 
-	// traverse the hashmap
-	int d = 0;
-	a3d_hashmapNode_t* node = self->head;
-	while(d < len)
+const void* a3d_hashmap_findKey(const a3d_hashmap_t* self,
+                                a3d_hashmapIter_t* iter,
+                                a3d_hashmapKey_t* key)
+{
+	assert(self);
+	assert(iter);
+	assert(key);
+
+	// reuse the cached lookup when no keys have moved
+	if((key->hashmap == self) &&
+	   (key->generation == self->generation))
 	{
-		if(key[d] == iter->key[d])
+		iter->hashmap = self;
+		iter->prefix  = 0;
+		iter->upper   = NULL;
+		if(self->ordered)
 		{
-			if(d == (len - 1))
-			{
-				if(node->val)
-				{
-					// hash already contains key
-					return 0;
-				}
+			a3d_hashmapNode_t* node = key->node;
+			memcpy(iter->key, key->key, key->len + 1);
+			iter->node   = node;
+			iter->offset = key->len - node->len;
+			return node->val;
+		}
 
-				// success
-				++self->size;
-				node->val = val;
-				return 1;
-			}
-			else if(node->down == NULL)
-			{
-				// insert a new down node
-				a3d_hashmapNode_t* down;
-				down = a3d_hashmapNode_new(node, self, key[d + 1]);
-				if(down == NULL)
-				{
-					a3d_hashmap_clean(self, node);
-					goto fail_add;
-				}
-				node->down = down;
-			}
+		iter->index = key->index;
+		return self->slots[key->index].val;
+	}
 
-			// down
-			++d;
-			node = node->down;
-			a3d_hashmapIter_update(iter, d, node);
-			continue;
+	const void* val;
+	val = a3d_hashmap_findHash(self, iter, key->key,
+	                           key->len, key->hash);
+	if(val)
+	{
+		key->hashmap    = self;
+		key->generation = self->generation;
+		if(self->ordered)
+		{
+			key->node = iter->node;
 		}
-		else if(key[d] < iter->key[d])
+		else
 		{
-			// insert a new prev node
-			a3d_hashmapNode_t* prev;
-			prev = a3d_hashmapNode_new(node->prev, self, key[d]);
-			if(prev == NULL)
-			{
-				a3d_hashmap_clean(self, node);
-				goto fail_add;
-			}
-			prev->next = node;
+			key->index = iter->index;
+		}
+	}
 
-			if(node->prev)
-			{
-				if(node->prev->next == node)
-				{
-					node->prev->next = prev;
-				}
-				else
-				{
-					node->prev->down = prev;
-				}
-			}
-			else
-			{
-				self->head = prev;
-			}
-			node->prev = prev;
+	return val;
+}
 
-			// sideways
-			node = prev;
-			a3d_hashmapIter_update(iter, d, node);
-			continue;
-		}
-		else if(node->next == NULL)
-		{
-			// append a new next node
-			a3d_hashmapNode_t* next;
-			next = a3d_hashmapNode_new(node, self, key[d]);
-			if(next == NULL)
-			{
-				a3d_hashmap_clean(self, node);
-				goto fail_add;
-			}
-			node->next = next;
+a3d_hashmapIter_t*
+a3d_hashmap_findPrefix(const a3d_hashmap_t* self,
+                       a3d_hashmapIter_t* iter,
+                       const char* prefix)
+{
+	assert(self);
+	assert(iter);
+	assert(prefix);
 
-			node = next;
-			a3d_hashmapIter_update(iter, d, node);
-			continue;
-		}
+	if(self->ordered == 0)
+	{
+		LOGE("invalid unordered hashmap");
+		return NULL;
+	}
 
-		// traverse to the next decision point
-		while(node->next && (key[d] > iter->key[d]))
-		{
-			// sideways
-			node = node->next;
-			a3d_hashmapIter_update(iter, d, node);
-		}
+	int len = strlen(prefix);
+	if(len >= A3D_HASHMAP_KEY_LEN)
+	{
+		LOGE("invalid len=%i", len);
+		return NULL;
+	}
+	else if(len == 0)
+	{
+		return a3d_hashmap_head(self, iter);
 	}
 
-	// the key/val can always be added before d equals len
-	assert(0);
+	iter->hashmap = self;
+	iter->prefix  = 0;
+	iter->upper   = NULL;
+	return a3d_hashmap_triePrefix(self, iter, prefix, len);
+}
 
-	// failure
-	fail_add:
-		if(created)
-		{
-			a3d_hashmapNode_delete(&self->head, self);
-		}
-	return 0;
+a3d_hashmapIter_t*
+a3d_hashmap_range(const a3d_hashmap_t* self,
+                  a3d_hashmapIter_t* iter,
+                  const char* lower,
+                  const char* upper)
+{
+	// lower and upper may be NULL
+	assert(self);
+	assert(iter);
+
+	if(self->ordered == 0)
+	{
+		LOGE("invalid unordered hashmap");
+		return NULL;
+	}
+
+	iter->hashmap = self;
+	iter->prefix  = 0;
+	iter->upper   = upper;
+	if(self->head == NULL)
+	{
+		return NULL;
+	}
+	else if((lower == NULL) || (lower[0] == '\0'))
+	{
+		a3d_hashmapIter_init(iter, self->head);
+		return a3d_hashmap_trieEndpoint(iter);
+	}
+
+	return a3d_hashmap_trieLower(self, iter, lower);
+}
+
+int a3d_hashmap_add(a3d_hashmap_t* self,
+                    const void* val,
+                    const char* key)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	int len = strlen(key);
+	if((len >= A3D_HASHMAP_KEY_LEN) || (len == 0))
+	{
+		LOGE("invalid key=%s, len=%i", key, len);
+		return 0;
+	}
+
+	unsigned int hash = 0;
+	if(self->ordered == 0)
+	{
+		hash = a3d_hashmap_hash(key, len);
+	}
+
+	return a3d_hashmap_addHash(self, val, key, len, hash);
 }
 
 int a3d_hashmap_addf(a3d_hashmap_t* self,
@@ -560,17 +1584,59 @@ int a3d_hashmap_addf(a3d_hashmap_t* self,
 	return a3d_hashmap_add(self, val, key);
 }
 
+int a3d_hashmap_addn(a3d_hashmap_t* self,
+                     const void* val,
+                     const char* key, int len)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	if(a3d_hashmap_validate(key, len) == 0)
+	{
+		return 0;
+	}
+
+	unsigned int hash = 0;
+	if(self->ordered == 0)
+	{
+		hash = a3d_hashmap_hash(key, len);
+	}
+
+	return a3d_hashmap_addHash(self, val, key, len, hash);
+}
+
+int a3d_hashmap_addKey(a3d_hashmap_t* self,
+                       const void* val,
+                       a3d_hashmapKey_t* key)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	return a3d_hashmap_addHash(self, val, key->key,
+	                           key->len, key->hash);
+}
+
 const void* a3d_hashmap_replace(a3d_hashmapIter_t* iter,
                                 const void*  val)
 {
 	assert(iter);
 	assert(val);
 
-	int d = iter->depth;
-	a3d_hashmapNode_t* node = iter->node[d];
+	const void* old;
+	if(iter->hashmap->ordered)
+	{
+		a3d_hashmapNode_t* node = iter->node;
+		old = node->val;
+		node->val = val;
+		return old;
+	}
 
-	const void* old = node->val;
-	node->val = val;
+	// the iterator only has const access to the hashmap
+	a3d_hashmapSlot_t* slot = &iter->hashmap->slots[iter->index];
+	old = slot->val;
+	slot->val = val;
 	return old;
 }
 
@@ -581,19 +1647,10 @@ const void* a3d_hashmap_remove(a3d_hashmap_t* self,
 	assert(_iter);
 	assert(*_iter);
 
-	a3d_hashmapIter_t* iter = *_iter;
-
-	// save node and update iter
-	int d = iter->depth;
-	a3d_hashmapNode_t* node = iter->node[d];
-	*_iter = a3d_hashmap_next(iter);
-
-	// clear value and clean traversal nodes
-	const void* val = node->val;
-	node->val = NULL;
-	a3d_hashmap_clean(self, node);
-
-	--self->size;
+	if(self->ordered)
+	{
+		return a3d_hashmap_trieRemove(self, _iter);
+	}
 
-	return val;
+	return a3d_hashmap_tableRemove(self, _iter);
 }
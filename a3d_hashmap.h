@@ -26,6 +26,11 @@
 
 #define A3D_HASHMAP_KEY_LEN 256
 
+// maximum edge label stored inline in a trie node
+#define A3D_HASHMAP_LABEL_LEN 15
+
+struct a3d_hashmap_s;
+
 typedef struct a3d_hashmapNode_s
 {
 	struct a3d_hashmapNode_s* prev;
@@ -33,24 +38,90 @@ typedef struct a3d_hashmapNode_s
 	struct a3d_hashmapNode_s* down;
 
 	const void* val;
-	char k;
+
+	// edge label (not null terminated)
+	unsigned char len;
+	char          k[A3D_HASHMAP_LABEL_LEN];
 } a3d_hashmapNode_t;
 
+// trie nodes are carved from chunks owned by the hashmap
+#define A3D_HASHMAP_CHUNK_SIZE 256
+
+typedef struct a3d_hashmapChunk_s
+{
+	struct a3d_hashmapChunk_s* next;
+} a3d_hashmapChunk_t;
+
 typedef struct
 {
-	int  depth;
-	char key[A3D_HASHMAP_KEY_LEN];
-	a3d_hashmapNode_t* node[A3D_HASHMAP_KEY_LEN];
+	unsigned int hash;
+	char*        key;
+	const void*  val;
+} a3d_hashmapSlot_t;
+
+typedef struct
+{
+	const struct a3d_hashmap_s* hashmap;
+
+	// hash table slot
+	int index;
+
+	// ordered trie bounds
+	// keys share the first prefix chars and are less
+	// than upper which must remain valid while iterating
+	int         prefix;
+	const char* upper;
+
+	// ordered trie node and the key offset of its label
+	// the key is updated incrementally by parent links
+	a3d_hashmapNode_t* node;
+	int                offset;
+	char               key[A3D_HASHMAP_KEY_LEN];
 } a3d_hashmapIter_t;
 
+// a key handle caches the hash and the lookup of a key
+// which is repeatedly used to access a hashmap
 typedef struct
+{
+	int          len;
+	unsigned int hash;
+	char         key[A3D_HASHMAP_KEY_LEN];
+
+	// cached lookup
+	const struct a3d_hashmap_s* hashmap;
+	unsigned int                generation;
+	int                         index;
+	a3d_hashmapNode_t*          node;
+} a3d_hashmapKey_t;
+
+typedef struct a3d_hashmap_s
 {
 	int size;
 	int nodes;
-	a3d_hashmapNode_t* head;
+
+	// incremented when a key may move which invalidates
+	// the lookups cached by a3d_hashmapKey_t
+	unsigned int generation;
+
+	// keys are stored in a trie when ordered
+	// or in an open addressing hash table
+	int                 ordered;
+	a3d_hashmapNode_t*  head;
+	int                 chunks;
+	int                 chunk_used;
+	a3d_hashmapChunk_t* chunk_head;
+	a3d_hashmapNode_t*  free_head;
+	int                 capacity;
+	int                 deleted;
+	a3d_hashmapSlot_t*  slots;
 } a3d_hashmap_t;
 
+int                a3d_hashmapKey_init(a3d_hashmapKey_t* self,
+                                       const char* key, int len);
+int                a3d_hashmapKey_initf(a3d_hashmapKey_t* self,
+                                        const char* fmt, ...);
 a3d_hashmap_t*     a3d_hashmap_new(void);
+a3d_hashmap_t*     a3d_hashmap_newOrdered(void);
 void               a3d_hashmap_delete(a3d_hashmap_t** _self);
 void               a3d_hashmap_discard(a3d_hashmap_t* self);
 int                a3d_hashmap_size(const a3d_hashmap_t* self);
@@ -68,12 +139,31 @@ const void*        a3d_hashmap_find(const a3d_hashmap_t* self,
 const void*        a3d_hashmap_findf(const a3d_hashmap_t* self,
                                      a3d_hashmapIter_t* iter,
                                      const char* fmt, ...);
+const void*        a3d_hashmap_findn(const a3d_hashmap_t* self,
+                                     a3d_hashmapIter_t* iter,
+                                     const char* key, int len);
+const void*        a3d_hashmap_findKey(const a3d_hashmap_t* self,
+                                       a3d_hashmapIter_t* iter,
+                                       a3d_hashmapKey_t* key);
+a3d_hashmapIter_t* a3d_hashmap_findPrefix(const a3d_hashmap_t* self,
+                                          a3d_hashmapIter_t* iter,
+                                          const char* prefix);
+a3d_hashmapIter_t* a3d_hashmap_range(const a3d_hashmap_t* self,
+                                     a3d_hashmapIter_t* iter,
+                                     const char* lower,
+                                     const char* upper);
 int                a3d_hashmap_add(a3d_hashmap_t* self,
                                    const void* val,
                                    const char* key);
 int                a3d_hashmap_addf(a3d_hashmap_t* self,
                                     const void* val,
                                     const char* fmt, ...);
+int                a3d_hashmap_addn(a3d_hashmap_t* self,
+                                    const void* val,
+                                    const char* key, int len);
+int                a3d_hashmap_addKey(a3d_hashmap_t* self,
+                                      const void* val,
+                                      a3d_hashmapKey_t* key);
 const void*        a3d_hashmap_replace(a3d_hashmapIter_t* iter,
                                        const void* val);
 const void*        a3d_hashmap_remove(a3d_hashmap_t* self,
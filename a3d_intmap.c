@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "a3d_intmap.h"
+#include <stdlib.h>
+#include <assert.h>
+
+#define LOG_TAG "a3d"
+#include "a3d_log.h"
+
+// the capacity is a power of two
+#define A3D_INTMAP_MIN_CAPACITY 16
+
+// empty slots have a NULL val and deleted slots
+// reference a3d_intmap_deleted
+static const char a3d_intmap_deleted = 0;
+#define A3D_INTMAP_DELETED ((const void*) &a3d_intmap_deleted)
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static uint64_t a3d_intmap_hash(uint64_t key)
+{
+	// splitmix64 finalizer spreads packed coordinates
+	// and sequential ids across the low bits
+	key ^= key >> 30;
+	key *= 0xBF58476D1CE4E5B9ULL;
+	key ^= key >> 27;
+	key *= 0x94D049BB133111EBULL;
+	key ^= key >> 31;
+	return key;
+}
+
+static int
+a3d_intmap_probe(const a3d_intmap_t* self, uint64_t key,
+                 int* _insert)
+{
+	// _insert may be NULL
+	assert(self);
+	assert(self->capacity > 0);
+
+	// linear probing where the load factor ensures an
+	// empty slot always terminates the probe
+	int mask   = self->capacity - 1;
+	int idx    = (int) (a3d_intmap_hash(key) & mask);
+	int insert = -1;
+	while(1)
+	{
+		a3d_intmapSlot_t* slot = &self->slots[idx];
+		if(slot->val == NULL)
+		{
+			if(insert < 0)
+			{
+				insert = idx;
+			}
+			break;
+		}
+		else if(slot->val == A3D_INTMAP_DELETED)
+		{
+			if(insert < 0)
+			{
+				insert = idx;
+			}
+		}
+		else if(slot->key == key)
+		{
+			return idx;
+		}
+
+		idx = (idx + 1) & mask;
+	}
+
+	if(_insert)
+	{
+		*_insert = insert;
+	}
+	return -1;
+}
+
+static int a3d_intmap_rehash(a3d_intmap_t* self, int capacity)
+{
+	assert(self);
+	assert(capacity >= A3D_INTMAP_MIN_CAPACITY);
+
+	a3d_intmapSlot_t* slots = (a3d_intmapSlot_t*)
+	                          calloc(capacity,
+	                                 sizeof(a3d_intmapSlot_t));
+	if(slots == NULL)
+	{
+		LOGE("calloc failed");
+		return 0;
+	}
+
+	// reinsert the keys which drops the deleted slots
+	int mask = capacity - 1;
+	int i;
+	for(i = 0; i < self->capacity; ++i)
+	{
+		a3d_intmapSlot_t* slot = &self->slots[i];
+		if((slot->val == NULL) ||
+		   (slot->val == A3D_INTMAP_DELETED))
+		{
+			continue;
+		}
+
+		int idx = (int) (a3d_intmap_hash(slot->key) & mask);
+		while(slots[idx].val)
+		{
+			idx = (idx + 1) & mask;
+		}
+		slots[idx] = *slot;
+	}
+
+	free(self->slots);
+	self->slots    = slots;
+	self->capacity = capacity;
+	self->deleted  = 0;
+
+	return 1;
+}
+
+static a3d_intmapIter_t*
+a3d_intmap_scan(a3d_intmapIter_t* iter, int idx)
+{
+	assert(iter);
+
+	// find the next occupied slot starting from idx
+	const a3d_intmap_t* self = iter->intmap;
+	while(idx < self->capacity)
+	{
+		const void* val = self->slots[idx].val;
+		if(val && (val != A3D_INTMAP_DELETED))
+		{
+			iter->index = idx;
+			return iter;
+		}
+		++idx;
+	}
+
+	return NULL;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+a3d_intmap_t* a3d_intmap_new(void)
+{
+	a3d_intmap_t* self = (a3d_intmap_t*)
+	                     malloc(sizeof(a3d_intmap_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->size     = 0;
+	self->capacity = 0;
+	self->deleted  = 0;
+	self->slots    = NULL;
+
+	return self;
+}
+
+void a3d_intmap_delete(a3d_intmap_t** _self)
+{
+	assert(_self);
+
+	a3d_intmap_t* self = *_self;
+	if(self)
+	{
+		if(self->size > 0)
+		{
+			LOGE("memory leak detected: size=%i", self->size);
+		}
+
+		free(self->slots);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+void a3d_intmap_discard(a3d_intmap_t* self)
+{
+	assert(self);
+
+	int i;
+	for(i = 0; i < self->capacity; ++i)
+	{
+		self->slots[i].key = 0;
+		self->slots[i].val = NULL;
+	}
+	self->size    = 0;
+	self->deleted = 0;
+}
+
+int a3d_intmap_size(const a3d_intmap_t* self)
+{
+	assert(self);
+
+	return self->size;
+}
+
+int a3d_intmap_intmapSize(const a3d_intmap_t* self)
+{
+	assert(self);
+
+	return (int) self->capacity*sizeof(a3d_intmapSlot_t);
+}
+
+int a3d_intmap_empty(const a3d_intmap_t* self)
+{
+	assert(self);
+
+	return self->size ? 0 : 1;
+}
+
+a3d_intmapIter_t* a3d_intmap_head(const a3d_intmap_t* self,
+                                  a3d_intmapIter_t* iter)
+{
+	assert(self);
+	assert(iter);
+
+	iter->intmap = self;
+	return a3d_intmap_scan(iter, 0);
+}
+
+a3d_intmapIter_t* a3d_intmap_next(a3d_intmapIter_t* iter)
+{
+	assert(iter);
+
+	return a3d_intmap_scan(iter, iter->index + 1);
+}
+
+const void* a3d_intmap_val(const a3d_intmapIter_t* iter)
+{
+	assert(iter);
+
+	return iter->intmap->slots[iter->index].val;
+}
+
+uint64_t a3d_intmap_key(const a3d_intmapIter_t* iter)
+{
+	assert(iter);
+
+	return iter->intmap->slots[iter->index].key;
+}
+
+const void* a3d_intmap_find(const a3d_intmap_t* self,
+                            a3d_intmapIter_t* iter,
+                            uint64_t key)
+{
+	assert(self);
+	assert(iter);
+
+	if(self->size == 0)
+	{
+		return NULL;
+	}
+
+	int idx = a3d_intmap_probe(self, key, NULL);
+	if(idx < 0)
+	{
+		return NULL;
+	}
+
+	iter->intmap = self;
+	iter->index  = idx;
+	return self->slots[idx].val;
+}
+
+int a3d_intmap_add(a3d_intmap_t* self,
+                   const void* val,
+                   uint64_t key)
+{
+	assert(self);
+	assert(val);
+
+	// grow the table or drop deleted slots to keep the
+	// load factor below 3/4
+	if((self->size + self->deleted + 1)*4 > 3*self->capacity)
+	{
+		int capacity = self->capacity;
+		if(capacity < A3D_INTMAP_MIN_CAPACITY)
+		{
+			capacity = A3D_INTMAP_MIN_CAPACITY;
+		}
+
+		while((self->size + 1)*2 > capacity)
+		{
+			capacity *= 2;
+		}
+
+		if(a3d_intmap_rehash(self, capacity) == 0)
+		{
+			return 0;
+		}
+	}
+
+	int insert = -1;
+	if(a3d_intmap_probe(self, key, &insert) >= 0)
+	{
+		// intmap already contains key
+		return 0;
+	}
+
+	a3d_intmapSlot_t* slot = &self->slots[insert];
+	if(slot->val == A3D_INTMAP_DELETED)
+	{
+		--self->deleted;
+	}
+	slot->key = key;
+	slot->val = val;
+	++self->size;
+
+	return 1;
+}
+
+const void* a3d_intmap_replace(a3d_intmapIter_t* iter,
+                               const void* val)
+{
+	assert(iter);
+	assert(val);
+
+	// the iterator only has const access to the intmap
+	a3d_intmapSlot_t* slot = &iter->intmap->slots[iter->index];
+	const void* old = slot->val;
+	slot->val = val;
+	return old;
+}
+
+const void* a3d_intmap_remove(a3d_intmap_t* self,
+                              a3d_intmapIter_t** _iter)
+{
+	assert(self);
+	assert(_iter);
+	assert(*_iter);
+
+	a3d_intmapIter_t* iter = *_iter;
+
+	// save slot and update iter
+	// deleted slots are kept so that the remaining
+	// slots do not move while iterating
+	a3d_intmapSlot_t* slot = &self->slots[iter->index];
+	*_iter = a3d_intmap_scan(iter, iter->index + 1);
+
+	const void* val = slot->val;
+	slot->key = 0;
+	slot->val = A3D_INTMAP_DELETED;
+	++self->deleted;
+	--self->size;
+
+	return val;
+}
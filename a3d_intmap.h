@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef a3d_intmap_H
+#define a3d_intmap_H
+
+#include <stdint.h>
+
+// intmaps store values by 64-bit keys such as packed
+// tile coordinates or GL object ids in an open addressing
+// hash table
+typedef struct
+{
+	uint64_t    key;
+	const void* val;
+} a3d_intmapSlot_t;
+
+struct a3d_intmap_s;
+
+typedef struct
+{
+	const struct a3d_intmap_s* intmap;
+	int                        index;
+} a3d_intmapIter_t;
+
+typedef struct a3d_intmap_s
+{
+	int               size;
+	int               capacity;
+	int               deleted;
+	a3d_intmapSlot_t* slots;
+} a3d_intmap_t;
+
+a3d_intmap_t*     a3d_intmap_new(void);
+void              a3d_intmap_delete(a3d_intmap_t** _self);
+void              a3d_intmap_discard(a3d_intmap_t* self);
+int               a3d_intmap_size(const a3d_intmap_t* self);
+int               a3d_intmap_intmapSize(const a3d_intmap_t* self);
+int               a3d_intmap_empty(const a3d_intmap_t* self);
+a3d_intmapIter_t* a3d_intmap_head(const a3d_intmap_t* self,
+                                  a3d_intmapIter_t* iter);
+a3d_intmapIter_t* a3d_intmap_next(a3d_intmapIter_t* iter);
+const void*       a3d_intmap_val(const a3d_intmapIter_t* iter);
+uint64_t          a3d_intmap_key(const a3d_intmapIter_t* iter);
+const void*       a3d_intmap_find(const a3d_intmap_t* self,
+                                  a3d_intmapIter_t* iter,
+                                  uint64_t key);
+int               a3d_intmap_add(a3d_intmap_t* self,
+                                 const void* val,
+                                 uint64_t key);
+const void*       a3d_intmap_replace(a3d_intmapIter_t* iter,
+                                     const void* val);
+const void*       a3d_intmap_remove(a3d_intmap_t* self,
+                                    a3d_intmapIter_t** _iter);
+
+#endif
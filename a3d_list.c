@@ -23,11 +23,392 @@
 
 #include "a3d_list.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #define LOG_TAG "a3d"
 #include "a3d_log.h"
 
+/***********************************************************
+* private - listpool                                       *
+***********************************************************/
+
+static a3d_listitem_t* a3d_listpool_alloc(a3d_listpool_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	// recycle a free item
+	a3d_listitem_t* item = self->free_head;
+	if(item)
+	{
+		self->free_head = item->next;
+		++self->items;
+		return item;
+	}
+
+	// allocate a new slab when the current slab is full
+	if((self->slab_head == NULL) ||
+	   (self->slab_used == self->slab_size))
+	{
+		a3d_listslab_t* slab;
+		slab = (a3d_listslab_t*)
+		       malloc(sizeof(a3d_listslab_t) +
+		              self->slab_size*sizeof(a3d_listitem_t));
+		if(slab == NULL)
+		{
+			LOGE("malloc failed");
+			return NULL;
+		}
+
+		slab->next      = self->slab_head;
+		self->slab_head = slab;
+		self->slab_used = 0;
+		++self->slabs;
+	}
+
+	// carve the item from the current slab
+	a3d_listitem_t* items = (a3d_listitem_t*) &self->slab_head[1];
+	item = &items[self->slab_used];
+	++self->slab_used;
+	++self->items;
+	return item;
+}
+
+static void a3d_listpool_free(a3d_listpool_t* self,
+                              a3d_listitem_t* item)
+{
+	assert(self);
+	assert(item);
+	LOGD("debug");
+
+	item->prev      = NULL;
+	item->next      = self->free_head;
+	item->data      = NULL;
+	self->free_head = item;
+	--self->items;
+}
+
+/***********************************************************
+* private - listindex                                      *
+***********************************************************/
+
+// the index is a skip-list where the list itself is the
+// bottom level and a lane is added to a random subset of
+// items to skip over runs of items in O(log n)
+#define A3D_LISTINDEX_MAX_HEIGHT 16
+
+typedef struct a3d_listlane_s
+{
+	a3d_listitem_t*        item;
+	int                    height;
+	struct a3d_listlane_s* next[];
+} a3d_listlane_t;
+
+typedef struct a3d_listindex_s
+{
+	a3d_listcmp_fn  compare;
+	int             height;
+	unsigned int    seed;
+	a3d_listlane_t* head[A3D_LISTINDEX_MAX_HEIGHT];
+} a3d_listindex_t;
+
+static a3d_listlane_t* a3d_listlane_new(a3d_listindex_t* index,
+                                        a3d_listitem_t* item)
+{
+	assert(index);
+	assert(item);
+	LOGD("debug");
+
+	// one item in four has a lane and each lane has a
+	// one in four chance to be promoted to the next level
+	int height = 0;
+	do
+	{
+		// xorshift32
+		unsigned int x = index->seed;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		index->seed = x;
+
+		if(x & 3)
+		{
+			break;
+		}
+		++height;
+	} while(height < A3D_LISTINDEX_MAX_HEIGHT);
+
+	if(height == 0)
+	{
+		return NULL;
+	}
+
+	a3d_listlane_t* self;
+	self = (a3d_listlane_t*)
+	       malloc(sizeof(a3d_listlane_t) +
+	              height*sizeof(a3d_listlane_t*));
+	if(self == NULL)
+	{
+		// the index remains valid without the lane
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->item   = item;
+	self->height = height;
+
+	return self;
+}
+
+static void a3d_listindex_clear(a3d_listindex_t* self)
+{
+	assert(self);
+
+	// every lane is linked on the lowest level
+	a3d_listlane_t* lane = self->head[0];
+	while(lane)
+	{
+		a3d_listlane_t* next = lane->next[0];
+		free(lane);
+		lane = next;
+	}
+
+	self->height = 0;
+	memset(self->head, 0, sizeof(self->head));
+}
+
+static void a3d_listindex_build(a3d_listindex_t* self,
+                                a3d_list_t* list)
+{
+	assert(self);
+	assert(list);
+
+	a3d_listindex_clear(self);
+
+	// append lanes for the existing items
+	// which must already be sorted
+	a3d_listlane_t* tail[A3D_LISTINDEX_MAX_HEIGHT];
+	a3d_listitem_t* item = list->head;
+	while(item)
+	{
+		a3d_listlane_t* lane = a3d_listlane_new(self, item);
+		if(lane)
+		{
+			int l;
+			for(l = 0; l < lane->height; ++l)
+			{
+				if(l < self->height)
+				{
+					tail[l]->next[l] = lane;
+				}
+				else
+				{
+					self->head[l] = lane;
+				}
+				lane->next[l] = NULL;
+				tail[l]       = lane;
+			}
+
+			if(lane->height > self->height)
+			{
+				self->height = lane->height;
+			}
+		}
+		item = item->next;
+	}
+}
+
+static a3d_listindex_t* a3d_listindex_new(a3d_list_t* list,
+                                          a3d_listcmp_fn compare)
+{
+	assert(list);
+	assert(compare);
+	LOGD("debug");
+
+	a3d_listindex_t* self = (a3d_listindex_t*)
+	                        calloc(1, sizeof(a3d_listindex_t));
+	if(self == NULL)
+	{
+		LOGE("calloc failed");
+		return NULL;
+	}
+
+	self->compare = compare;
+	self->height  = 0;
+	self->seed    = 0x9E3779B9;
+
+	a3d_listindex_build(self, list);
+
+	return self;
+}
+
+static void a3d_listindex_delete(a3d_listindex_t** _self)
+{
+	assert(_self);
+
+	a3d_listindex_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		a3d_listindex_clear(self);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+static a3d_listlane_t*
+a3d_listindex_search(a3d_listindex_t* self,
+                     const void* data, int inclusive,
+                     a3d_listlane_t** update)
+{
+	assert(self);
+	assert(data);
+	assert(update);
+	LOGD("debug");
+
+	// find the last lane on each level which is less than
+	// (or equal to when inclusive) data where NULL is head
+	a3d_listlane_t* prev = NULL;
+	int l;
+	for(l = A3D_LISTINDEX_MAX_HEIGHT - 1; l >= 0; --l)
+	{
+		if(l >= self->height)
+		{
+			update[l] = NULL;
+			continue;
+		}
+
+		a3d_listlane_t* next = prev ? prev->next[l] : self->head[l];
+		while(next)
+		{
+			int cmp = (*self->compare)(next->item->data, data);
+			if((cmp > 0) || ((cmp == 0) && (inclusive == 0)))
+			{
+				break;
+			}
+			prev = next;
+			next = next->next[l];
+		}
+		update[l] = prev;
+	}
+
+	return update[0];
+}
+
+static void a3d_listindex_add(a3d_listindex_t* self,
+                              a3d_listitem_t* item,
+                              a3d_listlane_t** update)
+{
+	assert(self);
+	assert(item);
+	assert(update);
+	LOGD("debug");
+
+	// update must be the inclusive search for item
+	a3d_listlane_t* lane = a3d_listlane_new(self, item);
+	if(lane == NULL)
+	{
+		return;
+	}
+
+	int l;
+	for(l = 0; l < lane->height; ++l)
+	{
+		a3d_listlane_t* prev = update[l];
+		if(prev)
+		{
+			lane->next[l] = prev->next[l];
+			prev->next[l] = lane;
+		}
+		else
+		{
+			lane->next[l] = self->head[l];
+			self->head[l] = lane;
+		}
+	}
+
+	if(lane->height > self->height)
+	{
+		self->height = lane->height;
+	}
+}
+
+static void a3d_listindex_remove(a3d_listindex_t* self,
+                                 a3d_list_t* list,
+                                 a3d_listitem_t* item)
+{
+	assert(self);
+	assert(list);
+	assert(item);
+	LOGD("debug");
+
+	a3d_listlane_t* update[A3D_LISTINDEX_MAX_HEIGHT];
+	a3d_listlane_t* lane;
+	int l;
+	if(item == list->head)
+	{
+		// the head item may only have the first lane
+		lane = self->head[0];
+		if((lane == NULL) || (lane->item != item))
+		{
+			return;
+		}
+
+		for(l = 0; l < lane->height; ++l)
+		{
+			update[l] = NULL;
+		}
+	}
+	else
+	{
+		// search for the lanes before the equal items and
+		// then walk the equal items to find the item's lane
+		lane = a3d_listindex_search(self, item->data, 0, update);
+		lane = lane ? lane->next[0] : self->head[0];
+		while(lane && (lane->item != item))
+		{
+			if((*self->compare)(lane->item->data, item->data) != 0)
+			{
+				// item does not have a lane
+				return;
+			}
+
+			for(l = 0; l < lane->height; ++l)
+			{
+				update[l] = lane;
+			}
+			lane = lane->next[0];
+		}
+
+		if(lane == NULL)
+		{
+			return;
+		}
+	}
+
+	// unlink the lane
+	for(l = 0; l < lane->height; ++l)
+	{
+		if(update[l])
+		{
+			update[l]->next[l] = lane->next[l];
+		}
+		else
+		{
+			self->head[l] = lane->next[l];
+		}
+	}
+	free(lane);
+
+	while((self->height > 0) &&
+	      (self->head[self->height - 1] == NULL))
+	{
+		--self->height;
+	}
+}
+
 /***********************************************************
 * private                                                  *
 ***********************************************************/
@@ -86,6 +467,11 @@ static void a3d_listitem_remove(a3d_listitem_t* self,
 		(*del_fn)(list->owner, self);
 	}
 
+	if(list->index)
+	{
+		a3d_listindex_remove(list->index, list, self);
+	}
+
 	// update next/prev nodes
 	if(self->prev)
 	{
@@ -182,14 +568,27 @@ static a3d_listitem_t* a3d_listitem_new(a3d_list_t* list,
 {
 	// prev and next can be NULL
 	assert(list);
+	assert(list->intrusive == 0);
 	assert(data);
 	LOGD("debug");
 
-	a3d_listitem_t* self = (a3d_listitem_t*) malloc(sizeof(a3d_listitem_t));
-	if(self == NULL)
+	a3d_listitem_t* self;
+	if(list->pool)
 	{
-		LOGE("malloc failed");
-		return NULL;
+		self = a3d_listpool_alloc(list->pool);
+		if(self == NULL)
+		{
+			return NULL;
+		}
+	}
+	else
+	{
+		self = (a3d_listitem_t*) malloc(sizeof(a3d_listitem_t));
+		if(self == NULL)
+		{
+			LOGE("malloc failed");
+			return NULL;
+		}
 	}
 
 	self->next = NULL;
@@ -215,13 +614,92 @@ static const void* a3d_listitem_delete(a3d_listitem_t** _self,
 		next = self->next;
 		data = self->data;
 		a3d_listitem_remove(self, list);
-		free(self);
+
+		// intrusive items are owned by the caller
+		if(list->pool)
+		{
+			a3d_listpool_free(list->pool, self);
+		}
+		else if(list->intrusive == 0)
+		{
+			free(self);
+		}
 		*_self = next;
 	}
 
 	return data;
 }
 
+static void a3d_list_spliced(a3d_list_t* from)
+{
+	assert(from);
+
+	// the items now belong to another list so the lanes
+	// of the index must not refer to them
+	from->head = NULL;
+	from->tail = NULL;
+	from->size = 0;
+	if(from->index)
+	{
+		a3d_listindex_clear(from->index);
+	}
+}
+
+/***********************************************************
+* public - listpool                                        *
+***********************************************************/
+
+a3d_listpool_t* a3d_listpool_new(int slab_size)
+{
+	assert(slab_size > 0);
+	LOGD("debug slab_size=%i", slab_size);
+
+	a3d_listpool_t* self = (a3d_listpool_t*)
+	                       malloc(sizeof(a3d_listpool_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->slab_size = slab_size;
+	self->slab_used = 0;
+	self->slabs     = 0;
+	self->items     = 0;
+	self->slab_head = NULL;
+	self->free_head = NULL;
+
+	return self;
+}
+
+void a3d_listpool_delete(a3d_listpool_t** _self)
+{
+	assert(_self);
+
+	a3d_listpool_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		if(self->items > 0)
+		{
+			LOGE("memory leak detected: items=%i", self->items);
+		}
+
+		// free whole slabs rather than individual items
+		a3d_listslab_t* slab = self->slab_head;
+		while(slab)
+		{
+			a3d_listslab_t* next = slab->next;
+			free(slab);
+			slab = next;
+		}
+
+		free(self);
+		*_self = NULL;
+	}
+}
+
 /***********************************************************
 * public                                                   *
 ***********************************************************/
@@ -237,13 +715,75 @@ a3d_list_t* a3d_list_new(void)
 		return NULL;
 	}
 
-	self->size   = 0;
-	self->head   = NULL;
-	self->tail   = NULL;
-	self->owner  = NULL;
-	self->add_fn = NULL;
-	self->del_fn = NULL;
-	self->mov_fn = NULL;
+	self->size       = 0;
+	self->head       = NULL;
+	self->tail       = NULL;
+	self->index      = NULL;
+	self->pool       = NULL;
+	self->pool_owner = 0;
+	self->intrusive  = 0;
+	self->owner      = NULL;
+	self->add_fn     = NULL;
+	self->del_fn     = NULL;
+	self->mov_fn     = NULL;
+
+	return self;
+}
+
+a3d_list_t* a3d_list_newPool(a3d_listpool_t* pool)
+{
+	// pool may be NULL
+	LOGD("debug");
+
+	// a NULL pool creates a private pool which is freed
+	// by a3d_list_delete
+	int pool_owner = 0;
+	if(pool == NULL)
+	{
+		pool = a3d_listpool_new(A3D_LISTPOOL_SLAB_SIZE);
+		if(pool == NULL)
+		{
+			return NULL;
+		}
+		pool_owner = 1;
+	}
+
+	a3d_list_t* self = a3d_list_new();
+	if(self == NULL)
+	{
+		goto fail_list;
+	}
+
+	self->pool       = pool;
+	self->pool_owner = pool_owner;
+
+	// success
+	return self;
+
+	// failure
+	fail_list:
+		if(pool_owner)
+		{
+			a3d_listpool_delete(&pool);
+		}
+	return NULL;
+}
+
+a3d_list_t* a3d_list_newIntrusive(void)
+{
+	LOGD("debug");
+
+	// intrusive lists link items which are embedded in the
+	// caller's own structs (see a3d_list_container) so the
+	// list never allocates or frees items and the functions
+	// which allocate items must not be used
+	a3d_list_t* self = a3d_list_new();
+	if(self == NULL)
+	{
+		return NULL;
+	}
+
+	self->intrusive = 1;
 
 	return self;
 }
@@ -267,6 +807,12 @@ void a3d_list_delete(a3d_list_t** _self)
 			a3d_list_pop(self);
 		}
 
+		a3d_listindex_delete(&self->index);
+		if(self->pool_owner)
+		{
+			a3d_listpool_delete(&self->pool);
+		}
+
 		free(self);
 		*_self = NULL;
 	}
@@ -386,7 +932,19 @@ a3d_listitem_t* a3d_list_findSorted(const a3d_list_t* self,
 	assert(compare);
 	LOGD("debug");
 
+	// skip to the last lane before data
 	a3d_listitem_t* item = self->head;
+	if(self->index && (self->index->compare == compare))
+	{
+		a3d_listlane_t* update[A3D_LISTINDEX_MAX_HEIGHT];
+		a3d_listlane_t* lane;
+		lane = a3d_listindex_search(self->index, data, 0, update);
+		if(lane)
+		{
+			item = lane->item->next;
+		}
+	}
+
 	while(item)
 	{
 		int cmp = (*compare)(data, item->data);
@@ -406,6 +964,7 @@ a3d_listitem_t* a3d_list_findSorted(const a3d_list_t* self,
 int a3d_list_push(a3d_list_t* self, const void* data)
 {
 	assert(self);
+	assert(self->index == NULL);
 	assert(data);
 	LOGD("debug");
 
@@ -424,6 +983,7 @@ const void* a3d_list_pop(a3d_list_t* self)
 int a3d_list_enqueue(a3d_list_t* self, const void* data)
 {
 	assert(self);
+	assert(self->index == NULL);
 	assert(data);
 	LOGD("debug");
 
@@ -447,6 +1007,7 @@ a3d_listitem_t* a3d_list_insert(a3d_list_t* self,
 	// a3d_list_insert(list, NULL, data) may be preferred over
 	// a3d_list_push(list, data) when a listitem is needed
 	assert(self);
+	assert(self->index == NULL);
 	assert(data);
 	LOGD("debug");
 
@@ -468,6 +1029,47 @@ a3d_listitem_t* a3d_list_insertSorted(a3d_list_t* self,
 	assert(compare);
 	assert(data);
 
+	// skip to the last lane before or equal to data
+	// and insert after any equal items
+	a3d_listindex_t* index = self->index;
+	if(index)
+	{
+		assert(index->compare == compare);
+
+		a3d_listlane_t* update[A3D_LISTINDEX_MAX_HEIGHT];
+		a3d_listlane_t* lane;
+		a3d_listitem_t* pos;
+		lane = a3d_listindex_search(index, data, 1, update);
+		pos  = lane ? lane->item->next : self->head;
+		while(pos && ((*compare)(data, pos->data) >= 0))
+		{
+			pos = pos->next;
+		}
+
+		a3d_listitem_t* item;
+		if(pos)
+		{
+			item = a3d_listitem_new(self, pos->prev, pos, data);
+		}
+		else
+		{
+			item = a3d_listitem_new(self, self->tail, NULL, data);
+		}
+
+		if(item)
+		{
+			a3d_listindex_add(index, item, update);
+		}
+		return item;
+	}
+
+	// items are often inserted in order so check the tail first
+	a3d_listitem_t* tail = a3d_list_tail(self);
+	if(tail && ((*compare)(data, a3d_list_peekitem(tail)) >= 0))
+	{
+		return a3d_list_append(self, tail, data);
+	}
+
 	a3d_listitem_t* item = a3d_list_head(self);
 	while(item)
 	{
@@ -491,6 +1093,7 @@ a3d_listitem_t* a3d_list_append(a3d_list_t* self,
 	// a3d_list_append(list, NULL, data) may be preferred over
 	// a3d_list_enqueue(list, data) when a listitem is needed
 	assert(self);
+	assert(self->index == NULL);
 	assert(data);
 	LOGD("debug");
 
@@ -511,6 +1114,7 @@ const void* a3d_list_replace(a3d_list_t* self,
 	assert(self);
 	assert(item);
 	assert(data);
+	assert(self->index == NULL);
 	LOGD("debug");
 
 	a3d_listnotify_fn mov_fn = self->mov_fn;
@@ -541,6 +1145,7 @@ void a3d_list_move(a3d_list_t* self,
 {
 	// to may be NULL
 	assert(self);
+	assert(self->index == NULL);
 	assert(from);
 	LOGD("debug");
 
@@ -563,6 +1168,7 @@ void a3d_list_moven(a3d_list_t* self,
 {
 	// to may be NULL
 	assert(self);
+	assert(self->index == NULL);
 	assert(from);
 	LOGD("debug");
 
@@ -587,7 +1193,10 @@ void a3d_list_swap(a3d_list_t* fromList,
 	// to may be NULL
 	assert(fromList);
 	assert(toList);
+	assert(toList->index == NULL);
 	assert(from);
+	assert(fromList->pool == toList->pool);
+	assert(fromList->intrusive == toList->intrusive);
 	LOGD("debug");
 
 	if(fromList == toList)
@@ -618,7 +1227,10 @@ void a3d_list_swapn(a3d_list_t* fromList,
 	// to may be NULL
 	assert(fromList);
 	assert(toList);
+	assert(toList->index == NULL);
 	assert(from);
+	assert(fromList->pool == toList->pool);
+	assert(fromList->intrusive == toList->intrusive);
 	LOGD("debug");
 
 	if(fromList == toList)
@@ -641,13 +1253,76 @@ void a3d_list_swapn(a3d_list_t* fromList,
 	}
 }
 
+void a3d_list_insertItem(a3d_list_t* self,
+                         a3d_listitem_t* pos,
+                         a3d_listitem_t* item,
+                         const void* data)
+{
+	// pos may be null for empty list or to insert at head
+	assert(self);
+	assert(self->index == NULL);
+	assert(self->intrusive);
+	assert(item);
+	assert(data);
+	LOGD("debug");
+
+	item->data = data;
+	if(pos)
+	{
+		a3d_listitem_add(item, self, pos->prev, pos);
+	}
+	else
+	{
+		a3d_listitem_add(item, self, NULL, self->head);
+	}
+}
+
+void a3d_list_appendItem(a3d_list_t* self,
+                         a3d_listitem_t* pos,
+                         a3d_listitem_t* item,
+                         const void* data)
+{
+	// pos may be null for empty list or to append at tail
+	assert(self);
+	assert(self->index == NULL);
+	assert(self->intrusive);
+	assert(item);
+	assert(data);
+	LOGD("debug");
+
+	item->data = data;
+	if(pos)
+	{
+		a3d_listitem_add(item, self, pos, pos->next);
+	}
+	else
+	{
+		a3d_listitem_add(item, self, self->tail, NULL);
+	}
+}
+
+const void* a3d_list_removeItem(a3d_list_t* self,
+                                a3d_listitem_t* item)
+{
+	assert(self);
+	assert(self->intrusive);
+	assert(item);
+	LOGD("debug");
+
+	a3d_listitem_remove(item, self);
+	return item->data;
+}
+
 void a3d_list_appendList(a3d_list_t* self,
                          a3d_list_t* from)
 {
 	assert(self);
+	assert(self->index == NULL);
 	assert(from);
 	assert(self->add_fn == NULL);
 	assert(self->del_fn == NULL);
+	assert(self->pool == from->pool);
+	assert(self->intrusive == from->intrusive);
 
 	if(from->size == 0)
 	{
@@ -658,9 +1333,7 @@ void a3d_list_appendList(a3d_list_t* self,
 		self->head = from->head;
 		self->tail = from->tail;
 		self->size = from->size;
-		from->head = NULL;
-		from->tail = NULL;
-		from->size = 0;
+		a3d_list_spliced(from);
 		return;
 	}
 
@@ -668,18 +1341,19 @@ void a3d_list_appendList(a3d_list_t* self,
 	from->head->prev = self->tail;
 	self->tail = from->tail;
 	self->size += from->size;
-	from->head = NULL;
-	from->tail = NULL;
-	from->size = 0;
+	a3d_list_spliced(from);
 }
 
 void a3d_list_insertList(a3d_list_t* self,
                          a3d_list_t* from)
 {
 	assert(self);
+	assert(self->index == NULL);
 	assert(from);
 	assert(self->add_fn == NULL);
 	assert(self->del_fn == NULL);
+	assert(self->pool == from->pool);
+	assert(self->intrusive == from->intrusive);
 
 	if(from->size == 0)
 	{
@@ -690,9 +1364,7 @@ void a3d_list_insertList(a3d_list_t* self,
 		self->head = from->head;
 		self->tail = from->tail;
 		self->size = from->size;
-		from->head = NULL;
-		from->tail = NULL;
-		from->size = 0;
+		a3d_list_spliced(from);
 		return;
 	}
 
@@ -700,9 +1372,212 @@ void a3d_list_insertList(a3d_list_t* self,
 	from->tail->next = self->head;
 	self->head = from->head;
 	self->size += from->size;
-	from->head = NULL;
-	from->tail = NULL;
-	from->size = 0;
+	a3d_list_spliced(from);
+}
+
+int a3d_list_index(a3d_list_t* self,
+                   a3d_listcmp_fn compare)
+{
+	// compare may be NULL to remove the index
+	assert(self);
+	LOGD("debug");
+
+	// the index speeds up findSorted and insertSorted for
+	// large sorted lists but requires that the list is only
+	// modified by insertSorted and the remove functions or
+	// emptied by a splice into another list
+	a3d_listindex_delete(&self->index);
+	if(compare == NULL)
+	{
+		return 1;
+	}
+
+	self->index = a3d_listindex_new(self, compare);
+	if(self->index == NULL)
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+void a3d_list_sort(a3d_list_t* self,
+                   a3d_listcmp_fn compare)
+{
+	assert(self);
+	assert(compare);
+	LOGD("debug");
+
+	if(self->size < 2)
+	{
+		return;
+	}
+
+	// stable bottom-up merge sort which relinks the items
+	// rather than allocating temporary storage
+	a3d_listitem_t* head = self->head;
+	a3d_listitem_t* tail = NULL;
+	int             run  = 1;
+	int             merges;
+	do
+	{
+		a3d_listitem_t* p = head;
+		head   = NULL;
+		tail   = NULL;
+		merges = 0;
+		while(p)
+		{
+			++merges;
+
+			// split the next two runs p and q
+			a3d_listitem_t* q = p;
+			int psize = 0;
+			int qsize = run;
+			while(q && (psize < run))
+			{
+				++psize;
+				q = q->next;
+			}
+
+			// merge p and q where ties are taken from p
+			while((psize > 0) || ((qsize > 0) && q))
+			{
+				a3d_listitem_t* e;
+				if(psize == 0)
+				{
+					e = q;
+					q = q->next;
+					--qsize;
+				}
+				else if((qsize == 0) || (q == NULL) ||
+				        ((*compare)(p->data, q->data) <= 0))
+				{
+					e = p;
+					p = p->next;
+					--psize;
+				}
+				else
+				{
+					e = q;
+					q = q->next;
+					--qsize;
+				}
+
+				if(tail)
+				{
+					tail->next = e;
+				}
+				else
+				{
+					head = e;
+				}
+				e->prev = tail;
+				tail    = e;
+			}
+
+			p = q;
+		}
+		tail->next = NULL;
+		run *= 2;
+	} while(merges > 1);
+
+	self->head = head;
+	self->tail = tail;
+
+	// rebuild the index lanes for the new order which
+	// keeps the index even if a lane cannot be allocated
+	if(self->index)
+	{
+		self->index->compare = compare;
+		a3d_listindex_build(self->index, self);
+	}
+
+	a3d_listnotify_fn mov_fn = self->mov_fn;
+	if(mov_fn)
+	{
+		a3d_listitem_t* iter = self->head;
+		while(iter)
+		{
+			(*mov_fn)(self->owner, iter);
+			iter = iter->next;
+		}
+	}
+}
+
+void a3d_list_mergeSorted(a3d_list_t* self,
+                          a3d_list_t* from,
+                          a3d_listcmp_fn compare)
+{
+	assert(self);
+	assert(self->index == NULL);
+	assert(from);
+	assert(compare);
+	assert(self->add_fn == NULL);
+	assert(self->del_fn == NULL);
+	assert(self->pool == from->pool);
+	assert(self->intrusive == from->intrusive);
+	LOGD("debug");
+
+	// merge two sorted lists into self where ties are
+	// taken from self so the merge is stable
+	if(from->size == 0)
+	{
+		return;
+	}
+	else if(self->size == 0)
+	{
+		a3d_list_appendList(self, from);
+		return;
+	}
+
+	a3d_listitem_t* a    = self->head;
+	a3d_listitem_t* b    = from->head;
+	a3d_listitem_t* head = NULL;
+	a3d_listitem_t* tail = NULL;
+	while(a && b)
+	{
+		a3d_listitem_t* e;
+		if((*compare)(a->data, b->data) <= 0)
+		{
+			e = a;
+			a = a->next;
+		}
+		else
+		{
+			e = b;
+			b = b->next;
+		}
+
+		if(tail)
+		{
+			tail->next = e;
+		}
+		else
+		{
+			head = e;
+		}
+		e->prev = tail;
+		tail    = e;
+	}
+
+	// the remaining items are already linked
+	if(a)
+	{
+		tail->next = a;
+		a->prev    = tail;
+		tail       = self->tail;
+	}
+	else
+	{
+		tail->next = b;
+		b->prev    = tail;
+		tail       = from->tail;
+	}
+
+	self->head  = head;
+	self->tail  = tail;
+	self->size += from->size;
+	a3d_list_spliced(from);
 }
 
 void a3d_list_notify(a3d_list_t* self,
@@ -24,6 +24,8 @@
 #ifndef a3d_list_H
 #define a3d_list_H
 
+#include <stddef.h>
+
 typedef int (*a3d_listcmp_fn)(const void* a, const void* b);
 
 typedef struct a3d_listitem_s
@@ -35,12 +37,54 @@ typedef struct a3d_listitem_s
 
 typedef void (*a3d_listnotify_fn)(void* owner, a3d_listitem_t* item);
 
+// returns the struct which contains an intrusive list item
+#define a3d_list_container(item, type, member) \
+	((type*) ((char*) (item) - offsetof(type, member)))
+
+// default number of items per slab for private pools
+#define A3D_LISTPOOL_SLAB_SIZE 64
+
+typedef struct a3d_listslab_s
+{
+	struct a3d_listslab_s* next;
+} a3d_listslab_t;
+
+// the listpool recycles list items to avoid a malloc/free
+// for every push/pop and may be shared by several lists
+// note that the listpool is not thread safe so lists that
+// share a pool must be protected by the same lock
+typedef struct
+{
+	int             slab_size;
+	int             slab_used;
+	int             slabs;
+	int             items;
+	a3d_listslab_t* slab_head;
+	a3d_listitem_t* free_head;
+} a3d_listpool_t;
+
+a3d_listpool_t* a3d_listpool_new(int slab_size);
+void            a3d_listpool_delete(a3d_listpool_t** _self);
+
+// skip-list index for sorted lists (see a3d_list_index)
+struct a3d_listindex_s;
+
 typedef struct
 {
 	int size;
 	a3d_listitem_t* head;
 	a3d_listitem_t* tail;
 
+	// optional index for sorted lists
+	struct a3d_listindex_s* index;
+
+	// optional item allocator
+	a3d_listpool_t* pool;
+	int             pool_owner;
+
+	// items are owned by the caller
+	int intrusive;
+
 	// notify callbacks
 	void*             owner;
 	a3d_listnotify_fn add_fn;
@@ -49,6 +93,8 @@ typedef struct
 } a3d_list_t;
 
 a3d_list_t*     a3d_list_new(void);
+a3d_list_t*     a3d_list_newPool(a3d_listpool_t* pool);
+a3d_list_t*     a3d_list_newIntrusive(void);
 void            a3d_list_delete(a3d_list_t** _self);
 void            a3d_list_discard(a3d_list_t* self);
 int             a3d_list_size(const a3d_list_t* self);
@@ -100,10 +146,27 @@ void            a3d_list_swapn(a3d_list_t* fromList,
                                a3d_list_t* toList,
                                a3d_listitem_t* from,
                                a3d_listitem_t* to);
+void            a3d_list_insertItem(a3d_list_t* self,
+                                    a3d_listitem_t* pos,
+                                    a3d_listitem_t* item,
+                                    const void* data);
+void            a3d_list_appendItem(a3d_list_t* self,
+                                    a3d_listitem_t* pos,
+                                    a3d_listitem_t* item,
+                                    const void* data);
+const void*     a3d_list_removeItem(a3d_list_t* self,
+                                    a3d_listitem_t* item);
 void            a3d_list_appendList(a3d_list_t* self,
                                     a3d_list_t* from);
 void            a3d_list_insertList(a3d_list_t* self,
                                     a3d_list_t* from);
+int             a3d_list_index(a3d_list_t* self,
+                               a3d_listcmp_fn compare);
+void            a3d_list_sort(a3d_list_t* self,
+                              a3d_listcmp_fn compare);
+void            a3d_list_mergeSorted(a3d_list_t* self,
+                                     a3d_list_t* from,
+                                     a3d_listcmp_fn compare);
 void            a3d_list_notify(a3d_list_t* self,
                                 void* owner,
                                 a3d_listnotify_fn add_fn,
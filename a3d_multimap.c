@@ -31,6 +31,9 @@
 #define LOG_TAG "a3d"
 #include "a3d_log.h"
 
+// index sorted value lists once they reach this size
+#define A3D_MULTIMAP_INDEX_SIZE 64
+
 /***********************************************************
 * public                                                   *
 ***********************************************************/
@@ -47,18 +50,27 @@ a3d_multimap_t* a3d_multimap_new(a3d_listcmp_fn compare)
 		return NULL;
 	}
 
-	self->hash = a3d_hashmap_new();
+	// keys are iterated in order
+	self->hash = a3d_hashmap_newOrdered();
 	if(self->hash == NULL)
 	{
 		goto fail_hash;
 	}
 
+	self->pool = a3d_listpool_new(A3D_LISTPOOL_SLAB_SIZE);
+	if(self->pool == NULL)
+	{
+		goto fail_pool;
+	}
+
 	self->compare = compare;
 
 	// success
 	return self;
 
 	// failure
+	fail_pool:
+		a3d_hashmap_delete(&self->hash);
 	fail_hash:
 		free(self);
 	return NULL;
@@ -72,6 +84,7 @@ void a3d_multimap_delete(a3d_multimap_t** _self)
 	if(self)
 	{
 		a3d_hashmap_delete(&self->hash);
+		a3d_listpool_delete(&self->pool);
 		free(self);
 		*_self = NULL;
 	}
@@ -81,7 +94,17 @@ void a3d_multimap_discard(a3d_multimap_t* self)
 {
 	assert(self);
 
-	a3d_hashmap_discard(self->hash);
+	// delete the value lists
+	a3d_hashmapIter_t  iterator;
+	a3d_hashmapIter_t* iter;
+	iter = a3d_hashmap_head(self->hash, &iterator);
+	while(iter)
+	{
+		a3d_list_t* list = (a3d_list_t*)
+		                   a3d_hashmap_remove(self->hash, &iter);
+		a3d_list_discard(list);
+		a3d_list_delete(&list);
+	}
 }
 
 int a3d_multimap_size(const a3d_multimap_t* self)
@@ -119,14 +142,13 @@ a3d_multimap_head(const a3d_multimap_t* self,
 	assert(self);
 	assert(iter);
 
-	iter->hiter = a3d_hashmap_head(self->hash, &iter->hiterator);
-	if(iter->hiter == NULL)
+	if(a3d_hashmap_head(self->hash, &iter->hiter) == NULL)
 	{
 		return NULL;
 	}
 
 	a3d_list_t* list = (a3d_list_t*)
-	                   a3d_hashmap_val(iter->hiter);
+	                   a3d_hashmap_val(&iter->hiter);
 	iter->item = a3d_list_head(list);
 
 	return iter;
@@ -142,14 +164,13 @@ a3d_multimapIter_t* a3d_multimap_next(a3d_multimapIter_t* iter)
 		return iter;
 	}
 
-	iter->hiter = a3d_hashmap_next(iter->hiter);
-	if(iter->hiter == NULL)
+	if(a3d_hashmap_next(&iter->hiter) == NULL)
 	{
 		return NULL;
 	}
 
 	a3d_list_t* list = (a3d_list_t*)
-	                   a3d_hashmap_val(iter->hiter);
+	                   a3d_hashmap_val(&iter->hiter);
 	iter->item = a3d_list_head(list);
 
 	return iter;
@@ -172,14 +193,13 @@ a3d_multimapIter_t* a3d_multimap_nextList(a3d_multimapIter_t* iter)
 {
 	assert(iter);
 
-	iter->hiter = a3d_hashmap_next(iter->hiter);
-	if(iter->hiter == NULL)
+	if(a3d_hashmap_next(&iter->hiter) == NULL)
 	{
 		return NULL;
 	}
 
 	a3d_list_t* list = (a3d_list_t*)
-	                   a3d_hashmap_val(iter->hiter);
+	                   a3d_hashmap_val(&iter->hiter);
 	iter->item = a3d_list_head(list);
 
 	return iter;
@@ -196,14 +216,14 @@ const a3d_list_t* a3d_multimap_list(const a3d_multimapIter_t* iter)
 {
 	assert(iter);
 
-	return (const a3d_list_t*) a3d_hashmap_val(iter->hiter);
+	return (const a3d_list_t*) a3d_hashmap_val(&iter->hiter);
 }
 
 const char* a3d_multimap_key(const a3d_multimapIter_t* iter)
 {
 	assert(iter);
 
-	return a3d_hashmap_key(iter->hiter);
+	return a3d_hashmap_key(&iter->hiter);
 }
 
 const a3d_list_t* a3d_multimap_find(const a3d_multimap_t* self,
@@ -214,11 +234,9 @@ const a3d_list_t* a3d_multimap_find(const a3d_multimap_t* self,
 	assert(iter);
 	assert(key);
 
-	iter->hiter = &iter->hiterator;
-
 	a3d_list_t* list;
 	list = (a3d_list_t*)
-	       a3d_hashmap_find(self->hash, iter->hiter, key);
+	       a3d_hashmap_find(self->hash, &iter->hiter, key);
 	if(list == NULL)
 	{
 		return NULL;
@@ -272,6 +290,13 @@ int a3d_multimap_add(a3d_multimap_t* self,
 			return 0;
 		}
 
+		// the index is optional so ignore failures
+		if((list->index == NULL) &&
+		   (a3d_list_size(list) >= A3D_MULTIMAP_INDEX_SIZE))
+		{
+			a3d_list_index(list, self->compare);
+		}
+
 		return 1;
 	}
 	else if(list)
@@ -286,7 +311,7 @@ int a3d_multimap_add(a3d_multimap_t* self,
 	}
 
 	// create a new list and add to hash
-	list = a3d_list_new();
+	list = a3d_list_newPool(self->pool);
 	if(list == NULL)
 	{
 		return 0;
@@ -341,7 +366,12 @@ const void* a3d_multimap_replace(a3d_multimapIter_t* iter,
 
 	a3d_list_t* list;
 	list = (a3d_list_t*)
-	       a3d_hashmap_val(iter->hiter);
+	       a3d_hashmap_val(&iter->hiter);
+
+	// the value may change the sort order so drop the
+	// index which is rebuilt by the next add
+	a3d_list_index(list, NULL);
+
 	return a3d_list_replace(list, iter->item, val);
 }
 
@@ -352,12 +382,13 @@ const void* a3d_multimap_remove(a3d_multimap_t* self,
 	assert(_iter);
 	assert(*_iter);
 
-	a3d_multimapIter_t* iter = *_iter;
+	a3d_multimapIter_t* iter  = *_iter;
+	a3d_hashmapIter_t*  hiter = &iter->hiter;
 
 	// remove item from list;
 	a3d_list_t* list;
 	list = (a3d_list_t*)
-	       a3d_hashmap_val(iter->hiter);
+	       a3d_hashmap_val(hiter);
 	const void* data = a3d_list_remove(list,
 	                                   &iter->item);
 
@@ -365,28 +396,28 @@ const void* a3d_multimap_remove(a3d_multimap_t* self,
 	// or if next item is NULL
 	if(a3d_list_empty(list))
 	{
-		a3d_hashmap_remove(self->hash, &iter->hiter);
+		a3d_hashmap_remove(self->hash, &hiter);
 		a3d_list_delete(&list);
-		if(iter->hiter)
+		if(hiter)
 		{
 			list = (a3d_list_t*)
-			       a3d_hashmap_val(iter->hiter);
+			       a3d_hashmap_val(hiter);
 			iter->item = a3d_list_head(list);
 		}
 	}
 	else if(iter->item == NULL)
 	{
-		iter->hiter = a3d_hashmap_next(iter->hiter);
-		if(iter->hiter)
+		hiter = a3d_hashmap_next(hiter);
+		if(hiter)
 		{
 			list = (a3d_list_t*)
-			       a3d_hashmap_val(iter->hiter);
+			       a3d_hashmap_val(hiter);
 			iter->item = a3d_list_head(list);
 		}
 	}
 
 	// check for iteration end
-	if(iter->hiter == NULL)
+	if(hiter == NULL)
 	{
 		*_iter = NULL;
 	}
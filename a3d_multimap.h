@@ -29,15 +29,18 @@
 
 typedef struct
 {
-	a3d_hashmapIter_t  hiterator;
-	a3d_hashmapIter_t* hiter;
-	a3d_listitem_t*    item;
+	a3d_hashmapIter_t hiter;
+	a3d_listitem_t*   item;
 } a3d_multimapIter_t;
 
 typedef struct
 {
-	a3d_hashmap_t* hash;
-	a3d_listcmp_fn compare;
+	// ordered so head/next iterate keys in order
+	a3d_hashmap_t*  hash;
+	a3d_listcmp_fn  compare;
+
+	// shared by all value lists
+	a3d_listpool_t* pool;
 } a3d_multimap_t;
 
 a3d_multimap_t*     a3d_multimap_new(a3d_listcmp_fn compare);
@@ -0,0 +1,631 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "a3d_sharedmap.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sched.h>
+
+#define LOG_TAG "a3d"
+#include "a3d_log.h"
+
+// reserved slot hashes
+#define A3D_SHAREDMAP_SLOT_EMPTY   0
+#define A3D_SHAREDMAP_SLOT_DELETED 1
+
+// the capacity is a power of two
+#define A3D_SHAREDMAP_MIN_CAPACITY 16
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static unsigned int
+a3d_sharedmap_hash(const char* key, int* _len)
+{
+	assert(key);
+	assert(_len);
+
+	// FNV-1a
+	unsigned int h   = 2166136261U;
+	int          len = 0;
+	while(key[len])
+	{
+		h ^= (unsigned char) key[len];
+		h *= 16777619U;
+		++len;
+	}
+
+	// mix the high bits into the low bits which
+	// select the slot
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+
+	*_len = len;
+
+	// reserve the empty and deleted hashes
+	return (h <= A3D_SHAREDMAP_SLOT_DELETED) ? (h + 2) : h;
+}
+
+static a3d_sharedmapTable_t* a3d_sharedmapTable_new(int capacity)
+{
+	assert(capacity >= A3D_SHAREDMAP_MIN_CAPACITY);
+
+	a3d_sharedmapTable_t* self;
+	self = (a3d_sharedmapTable_t*)
+	       calloc(1, sizeof(a3d_sharedmapTable_t) +
+	                 capacity*sizeof(a3d_sharedmapSlot_t));
+	if(self == NULL)
+	{
+		LOGE("calloc failed");
+		return NULL;
+	}
+
+	self->capacity = capacity;
+
+	return self;
+}
+
+static int
+a3d_sharedmap_probe(const a3d_sharedmapTable_t* table,
+                    const char* key, unsigned int hash)
+{
+	assert(table);
+	assert(key);
+
+	// slots are published by the hash so the key and
+	// val are valid once the hash is observed
+	int mask = table->capacity - 1;
+	int idx  = (int) (hash & mask);
+	while(1)
+	{
+		const a3d_sharedmapSlot_t* slot = &table->slots[idx];
+		unsigned int h = __atomic_load_n(&slot->hash,
+		                                 __ATOMIC_ACQUIRE);
+		if(h == A3D_SHAREDMAP_SLOT_EMPTY)
+		{
+			return -1;
+		}
+		else if((h == hash) && (strcmp(slot->key, key) == 0))
+		{
+			return idx;
+		}
+
+		idx = (idx + 1) & mask;
+	}
+}
+
+static void a3d_sharedmap_wait(a3d_sharedmap_t* self)
+{
+	assert(self);
+
+	// wait for the readers which entered before the
+	// epoch was advanced
+	unsigned long epoch;
+	epoch = __atomic_fetch_add(&self->epoch, 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	int i;
+	for(i = 0; i < self->readers; ++i)
+	{
+		while(1)
+		{
+			unsigned long e;
+			e = __atomic_load_n(&self->reader[i].epoch,
+			                    __ATOMIC_SEQ_CST);
+			if((e == 0) || (e > epoch))
+			{
+				break;
+			}
+			sched_yield();
+		}
+	}
+}
+
+static void a3d_sharedmap_reclaim(a3d_sharedmap_t* self)
+{
+	assert(self);
+
+	// find the oldest epoch of the active readers
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	int i;
+	unsigned long oldest = (unsigned long) -1;
+	for(i = 0; i < self->readers; ++i)
+	{
+		unsigned long e;
+		e = __atomic_load_n(&self->reader[i].epoch,
+		                    __ATOMIC_SEQ_CST);
+		if(e && (e < oldest))
+		{
+			oldest = e;
+		}
+	}
+
+	// free the memory retired before the oldest epoch
+	a3d_sharedmapRetired_t** link = &self->retired;
+	while(*link)
+	{
+		a3d_sharedmapRetired_t* retired = *link;
+		if(retired->epoch < oldest)
+		{
+			*link = retired->next;
+			free(retired->ptr);
+			free(retired);
+		}
+		else
+		{
+			link = &retired->next;
+		}
+	}
+}
+
+static void a3d_sharedmap_retire(a3d_sharedmap_t* self,
+                                 void* ptr)
+{
+	assert(self);
+	assert(ptr);
+
+	// ptr must be unreachable for new readers
+	a3d_sharedmapRetired_t* retired;
+	retired = (a3d_sharedmapRetired_t*)
+	          malloc(sizeof(a3d_sharedmapRetired_t));
+	if(retired == NULL)
+	{
+		LOGE("malloc failed");
+
+		// fall back to waiting for the readers
+		a3d_sharedmap_wait(self);
+		free(ptr);
+		return;
+	}
+
+	// readers which observe a later epoch cannot
+	// reference ptr
+	retired->epoch = __atomic_fetch_add(&self->epoch, 1,
+	                                    __ATOMIC_SEQ_CST);
+	retired->ptr   = ptr;
+	retired->next  = self->retired;
+	self->retired  = retired;
+}
+
+static int
+a3d_sharedmap_grow(a3d_sharedmap_t* self)
+{
+	assert(self);
+
+	// grow the table or drop deleted slots to keep the
+	// load factor below 3/4
+	a3d_sharedmapTable_t* table = self->table;
+	int capacity = table ? table->capacity : 0;
+	if((self->size + self->deleted + 1)*4 <= 3*capacity)
+	{
+		return 1;
+	}
+
+	if(capacity < A3D_SHAREDMAP_MIN_CAPACITY)
+	{
+		capacity = A3D_SHAREDMAP_MIN_CAPACITY;
+	}
+
+	while((self->size + 1)*2 > capacity)
+	{
+		capacity *= 2;
+	}
+
+	a3d_sharedmapTable_t* copy;
+	copy = a3d_sharedmapTable_new(capacity);
+	if(copy == NULL)
+	{
+		return 0;
+	}
+
+	// copy the keys which remain owned by the slots
+	if(table)
+	{
+		int mask = capacity - 1;
+		int i;
+		for(i = 0; i < table->capacity; ++i)
+		{
+			a3d_sharedmapSlot_t* slot = &table->slots[i];
+			if(slot->hash <= A3D_SHAREDMAP_SLOT_DELETED)
+			{
+				continue;
+			}
+
+			int idx = (int) (slot->hash & mask);
+			while(copy->slots[idx].hash)
+			{
+				idx = (idx + 1) & mask;
+			}
+			copy->slots[idx] = *slot;
+		}
+	}
+
+	// publish the copy and retire the table
+	__atomic_store_n(&self->table, copy, __ATOMIC_RELEASE);
+	if(table)
+	{
+		a3d_sharedmap_retire(self, (void*) table);
+	}
+	self->deleted = 0;
+
+	return 1;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+a3d_sharedmap_t* a3d_sharedmap_new(int readers)
+{
+	assert(readers > 0);
+
+	a3d_sharedmap_t* self = (a3d_sharedmap_t*)
+	                        malloc(sizeof(a3d_sharedmap_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->reader = (a3d_sharedmapReader_t*)
+	               calloc(readers, sizeof(a3d_sharedmapReader_t));
+	if(self->reader == NULL)
+	{
+		LOGE("calloc failed");
+		goto fail_reader;
+	}
+
+	if(pthread_mutex_init(&self->mutex, NULL) != 0)
+	{
+		LOGE("pthread_mutex_init failed");
+		goto fail_mutex;
+	}
+
+	// epoch 0 marks inactive readers
+	self->epoch   = 1;
+	self->readers = readers;
+	self->table   = NULL;
+	self->size    = 0;
+	self->deleted = 0;
+	self->retired = NULL;
+
+	// success
+	return self;
+
+	// failure
+	fail_mutex:
+		free(self->reader);
+	fail_reader:
+		free(self);
+	return NULL;
+}
+
+void a3d_sharedmap_delete(a3d_sharedmap_t** _self)
+{
+	assert(_self);
+
+	a3d_sharedmap_t* self = *_self;
+	if(self)
+	{
+		if(self->size > 0)
+		{
+			LOGE("memory leak detected: size=%i", self->size);
+		}
+
+		// the readers must be finished
+		a3d_sharedmap_discard(self);
+		a3d_sharedmap_wait(self);
+		a3d_sharedmap_reclaim(self);
+		assert(self->retired == NULL);
+
+		pthread_mutex_destroy(&self->mutex);
+		free(self->reader);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+void a3d_sharedmap_discard(a3d_sharedmap_t* self)
+{
+	assert(self);
+
+	pthread_mutex_lock(&self->mutex);
+
+	// unpublish the table and retire the keys
+	a3d_sharedmapTable_t* table = self->table;
+	if(table)
+	{
+		__atomic_store_n(&self->table, NULL, __ATOMIC_RELEASE);
+
+		int i;
+		for(i = 0; i < table->capacity; ++i)
+		{
+			a3d_sharedmapSlot_t* slot = &table->slots[i];
+			if(slot->hash > A3D_SHAREDMAP_SLOT_DELETED)
+			{
+				a3d_sharedmap_retire(self, (void*) slot->key);
+			}
+		}
+		a3d_sharedmap_retire(self, (void*) table);
+	}
+
+	self->size    = 0;
+	self->deleted = 0;
+	a3d_sharedmap_reclaim(self);
+
+	pthread_mutex_unlock(&self->mutex);
+}
+
+int a3d_sharedmap_size(a3d_sharedmap_t* self)
+{
+	assert(self);
+
+	pthread_mutex_lock(&self->mutex);
+	int size = self->size;
+	pthread_mutex_unlock(&self->mutex);
+
+	return size;
+}
+
+void a3d_sharedmap_readLock(a3d_sharedmap_t* self, int tid)
+{
+	assert(self);
+	assert((tid >= 0) && (tid < self->readers));
+
+	a3d_sharedmapReader_t* reader = &self->reader[tid];
+	assert(reader->epoch == 0);
+
+	// announce the reader before loading the table
+	unsigned long epoch;
+	epoch = __atomic_load_n(&self->epoch, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&reader->epoch, epoch, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void a3d_sharedmap_readUnlock(a3d_sharedmap_t* self, int tid)
+{
+	assert(self);
+	assert((tid >= 0) && (tid < self->readers));
+
+	a3d_sharedmapReader_t* reader = &self->reader[tid];
+	assert(reader->epoch);
+
+	__atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+const void* a3d_sharedmap_find(const a3d_sharedmap_t* self,
+                               const char* key)
+{
+	assert(self);
+	assert(key);
+
+	int len;
+	unsigned int hash = a3d_sharedmap_hash(key, &len);
+	if((len >= A3D_SHAREDMAP_KEY_LEN) || (len == 0))
+	{
+		LOGE("invalid len=%i", len);
+		return NULL;
+	}
+
+	const a3d_sharedmapTable_t* table;
+	table = __atomic_load_n(&self->table, __ATOMIC_ACQUIRE);
+	if(table == NULL)
+	{
+		return NULL;
+	}
+
+	int idx = a3d_sharedmap_probe(table, key, hash);
+	if(idx < 0)
+	{
+		return NULL;
+	}
+
+	return __atomic_load_n(&table->slots[idx].val,
+	                       __ATOMIC_ACQUIRE);
+}
+
+const void* a3d_sharedmap_findf(const a3d_sharedmap_t* self,
+                                const char* fmt, ...)
+{
+	assert(self);
+	assert(fmt);
+
+	char key[A3D_SHAREDMAP_KEY_LEN];
+	va_list argptr;
+	va_start(argptr, fmt);
+	vsnprintf(key, A3D_SHAREDMAP_KEY_LEN, fmt, argptr);
+	va_end(argptr);
+
+	return a3d_sharedmap_find(self, key);
+}
+
+int a3d_sharedmap_add(a3d_sharedmap_t* self,
+                      const void* val,
+                      const char* key)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	int len;
+	unsigned int hash = a3d_sharedmap_hash(key, &len);
+	if((len >= A3D_SHAREDMAP_KEY_LEN) || (len == 0))
+	{
+		LOGE("invalid key=%s, len=%i", key, len);
+		return 0;
+	}
+
+	pthread_mutex_lock(&self->mutex);
+
+	if(self->table &&
+	   (a3d_sharedmap_probe(self->table, key, hash) >= 0))
+	{
+		// sharedmap already contains key
+		goto fail_add;
+	}
+
+	if(a3d_sharedmap_grow(self) == 0)
+	{
+		goto fail_add;
+	}
+
+	char* copy = (char*) malloc(len + 1);
+	if(copy == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_add;
+	}
+	memcpy(copy, key, len + 1);
+
+	// deleted slots are not reused since readers may
+	// still be comparing their keys
+	a3d_sharedmapTable_t* table = self->table;
+	int mask = table->capacity - 1;
+	int idx  = (int) (hash & mask);
+	while(table->slots[idx].hash != A3D_SHAREDMAP_SLOT_EMPTY)
+	{
+		idx = (idx + 1) & mask;
+	}
+
+	// publish the slot
+	a3d_sharedmapSlot_t* slot = &table->slots[idx];
+	slot->key = copy;
+	__atomic_store_n(&slot->val, val, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->hash, hash, __ATOMIC_RELEASE);
+	++self->size;
+
+	a3d_sharedmap_reclaim(self);
+	pthread_mutex_unlock(&self->mutex);
+
+	// success
+	return 1;
+
+	// failure
+	fail_add:
+		pthread_mutex_unlock(&self->mutex);
+	return 0;
+}
+
+int a3d_sharedmap_addf(a3d_sharedmap_t* self,
+                       const void* val,
+                       const char* fmt, ...)
+{
+	assert(self);
+	assert(val);
+	assert(fmt);
+
+	char key[A3D_SHAREDMAP_KEY_LEN];
+	va_list argptr;
+	va_start(argptr, fmt);
+	vsnprintf(key, A3D_SHAREDMAP_KEY_LEN, fmt, argptr);
+	va_end(argptr);
+
+	return a3d_sharedmap_add(self, val, key);
+}
+
+const void* a3d_sharedmap_replace(a3d_sharedmap_t* self,
+                                  const void* val,
+                                  const char* key)
+{
+	assert(self);
+	assert(val);
+	assert(key);
+
+	int len;
+	unsigned int hash = a3d_sharedmap_hash(key, &len);
+
+	pthread_mutex_lock(&self->mutex);
+
+	const void* old = NULL;
+	if(self->table)
+	{
+		int idx = a3d_sharedmap_probe(self->table, key, hash);
+		if(idx >= 0)
+		{
+			a3d_sharedmapSlot_t* slot = &self->table->slots[idx];
+			old = slot->val;
+			__atomic_store_n(&slot->val, val, __ATOMIC_RELEASE);
+		}
+	}
+
+	pthread_mutex_unlock(&self->mutex);
+
+	return old;
+}
+
+const void* a3d_sharedmap_remove(a3d_sharedmap_t* self,
+                                 const char* key)
+{
+	assert(self);
+	assert(key);
+
+	int len;
+	unsigned int hash = a3d_sharedmap_hash(key, &len);
+
+	pthread_mutex_lock(&self->mutex);
+
+	const void* val = NULL;
+	if(self->table)
+	{
+		int idx = a3d_sharedmap_probe(self->table, key, hash);
+		if(idx >= 0)
+		{
+			// unpublish the slot and retire the key
+			a3d_sharedmapSlot_t* slot = &self->table->slots[idx];
+			val = slot->val;
+			__atomic_store_n(&slot->hash,
+			                 A3D_SHAREDMAP_SLOT_DELETED,
+			                 __ATOMIC_RELEASE);
+			a3d_sharedmap_retire(self, (void*) slot->key);
+			--self->size;
+			++self->deleted;
+
+			a3d_sharedmap_reclaim(self);
+		}
+	}
+
+	pthread_mutex_unlock(&self->mutex);
+
+	return val;
+}
+
+void a3d_sharedmap_synchronize(a3d_sharedmap_t* self)
+{
+	assert(self);
+
+	// removed or replaced values may be freed once the
+	// readers which might reference them have finished
+	a3d_sharedmap_wait(self);
+
+	pthread_mutex_lock(&self->mutex);
+	a3d_sharedmap_reclaim(self);
+	pthread_mutex_unlock(&self->mutex);
+}
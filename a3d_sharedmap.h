@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef a3d_sharedmap_H
+#define a3d_sharedmap_H
+
+#include <pthread.h>
+
+#define A3D_SHAREDMAP_KEY_LEN 256
+
+// sharedmaps are read-mostly string maps which may be
+// shared with workq threads
+//
+// readers are lock-free and must bracket finds and any use
+// of the values with readLock/readUnlock using a reader id
+// in [0, readers) such as the workq tid
+//
+// writers are serialized by a mutex and removed keys and
+// tables are reclaimed once no reader can reference them
+// however removed or replaced values are owned by the
+// caller who must call synchronize before freeing them
+
+typedef struct
+{
+	unsigned int hash;
+	char*        key;
+	const void*  val;
+} a3d_sharedmapSlot_t;
+
+typedef struct
+{
+	int                 capacity;
+	a3d_sharedmapSlot_t slots[];
+} a3d_sharedmapTable_t;
+
+// reader slots are padded to avoid false sharing
+typedef struct
+{
+	unsigned long epoch;
+	char          pad[64 - sizeof(unsigned long)];
+} a3d_sharedmapReader_t;
+
+typedef struct a3d_sharedmapRetired_s
+{
+	unsigned long                  epoch;
+	void*                          ptr;
+	struct a3d_sharedmapRetired_s* next;
+} a3d_sharedmapRetired_t;
+
+typedef struct
+{
+	// readers
+	unsigned long          epoch;
+	int                    readers;
+	a3d_sharedmapReader_t* reader;
+	a3d_sharedmapTable_t*  table;
+
+	// writers
+	int                     size;
+	int                     deleted;
+	a3d_sharedmapRetired_t* retired;
+	pthread_mutex_t         mutex;
+} a3d_sharedmap_t;
+
+a3d_sharedmap_t* a3d_sharedmap_new(int readers);
+void             a3d_sharedmap_delete(a3d_sharedmap_t** _self);
+void             a3d_sharedmap_discard(a3d_sharedmap_t* self);
+int              a3d_sharedmap_size(a3d_sharedmap_t* self);
+void             a3d_sharedmap_readLock(a3d_sharedmap_t* self,
+                                        int tid);
+void             a3d_sharedmap_readUnlock(a3d_sharedmap_t* self,
+                                          int tid);
+const void*      a3d_sharedmap_find(const a3d_sharedmap_t* self,
+                                    const char* key);
+const void*      a3d_sharedmap_findf(const a3d_sharedmap_t* self,
+                                     const char* fmt, ...);
+int              a3d_sharedmap_add(a3d_sharedmap_t* self,
+                                   const void* val,
+                                   const char* key);
+int              a3d_sharedmap_addf(a3d_sharedmap_t* self,
+                                    const void* val,
+                                    const char* fmt, ...);
+const void*      a3d_sharedmap_replace(a3d_sharedmap_t* self,
+                                       const void* val,
+                                       const char* key);
+const void*      a3d_sharedmap_remove(a3d_sharedmap_t* self,
+                                      const char* key);
+void             a3d_sharedmap_synchronize(a3d_sharedmap_t* self);
+
+#endif
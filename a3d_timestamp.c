@@ -23,6 +23,7 @@
 
 #include <sys/time.h>
 #include <stdlib.h>
+#include <time.h>
 #include "a3d_timestamp.h"
 
 #define LOG_TAG "a3d"
@@ -38,3 +39,11 @@ double a3d_timestamp(void)
 	gettimeofday(&t, NULL);
 	return (double) t.tv_sec + ((double) t.tv_usec)/1000000.0;
 }
+
+uint64_t a3d_timestamp_ns(void)
+{
+	// monotonic clock for measuring intervals
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return 1000000000ULL*((uint64_t) t.tv_sec) + (uint64_t) t.tv_nsec;
+}
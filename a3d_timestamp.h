@@ -24,6 +24,9 @@
 #ifndef a3d_timestamp_H
 #define a3d_timestamp_H
 
-double a3d_timestamp(void);
+#include <stdint.h>
+
+double   a3d_timestamp(void);
+uint64_t a3d_timestamp_ns(void);
 
 #endif
@@ -22,8 +22,13 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <time.h>
 #include <unistd.h>
+#include "a3d_timestamp.h"
 #include "a3d_workq.h"
 
 #define LOG_TAG "a3d"
@@ -37,139 +42,2376 @@
 const int A3D_WORKQ_RUNNING = 0;
 const int A3D_WORKQ_STOP    = 1;
 
-// force purge a task or workq
-const int A3D_WORKQ_PURGE = -1;
+// epoch of a task which is purged regardless of age
+// the workq epoch starts at 1
+const uint64_t A3D_WORKQ_PURGE = 0;
 
-static a3d_workqnode_t* a3d_workqnode_new(void* task, int purge_id,
+// node queue
+const int A3D_WORKQ_QUEUE_PENDING  = 0;
+const int A3D_WORKQ_QUEUE_ACTIVE   = 1;
+const int A3D_WORKQ_QUEUE_COMPLETE = 2;
+const int A3D_WORKQ_QUEUE_RESERVED = 3;
+const int A3D_WORKQ_QUEUE_BLOCKED  = 4;
+
+// thread slot state
+const int A3D_WORKQ_THREAD_NONE    = 0;
+const int A3D_WORKQ_THREAD_RUNNING = 1;
+const int A3D_WORKQ_THREAD_RETIRED = 2;
+
+// stride of a pool queue with weight 1
+const uint64_t A3D_WORKQ_POOL_STRIDE = 1 << 20;
+
+// default dynamic thread thresholds
+const int    A3D_WORKQ_SCALE_BACKLOG = 4;
+const double A3D_WORKQ_SCALE_LATENCY = 0.05;
+const double A3D_WORKQ_SCALE_TIMEOUT = 5.0;
+
+static a3d_workqnode_t* a3d_workqnode_new(void* task, uint64_t epoch,
                                           int priority)
 {
 	assert(task);
-	assert((purge_id == 0) || (purge_id == 1));
-	LOGD("debug task=%p, purge_id=%i, priority=%i",
-	     task, purge_id, priority);
+	assert(epoch > 0);
+	LOGD("debug task=%p, epoch=%i, priority=%i",
+	     task, (int) epoch, priority);
 
 	a3d_workqnode_t* self = (a3d_workqnode_t*) malloc(sizeof(a3d_workqnode_t));
 	if(!self)
 	{
-		LOGE("malloc failed");
-		return NULL;
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->status   = A3D_WORKQ_PENDING;
+	self->priority = priority;
+	self->epoch    = epoch;
+	self->queue    = A3D_WORKQ_QUEUE_PENDING;
+	self->task     = task;
+	self->heap_idx = -1;
+	self->seq      = 0;
+	self->rank     = priority;
+	self->deadline = 0;
+	self->expired  = 0;
+	self->tid      = -1;
+	self->next     = NULL;
+	self->cancel   = 0;
+
+	self->prereqs    = NULL;
+	self->dependents = NULL;
+
+	self->t_enqueue  = 0;
+	self->t_complete = 0;
+
+	return self;
+}
+
+static void a3d_workqnode_delete(a3d_workqnode_t** _self)
+{
+	assert(_self);
+
+	a3d_workqnode_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		a3d_array_delete(&self->prereqs);
+		a3d_array_delete(&self->dependents);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+static int a3d_workqhist_index(uint64_t value)
+{
+	if(value < 8)
+	{
+		return (int) value;
+	}
+
+	// 8 sub-buckets per power of two
+	int msb = 63 - __builtin_clzll(value);
+	int sub = (int) ((value >> (msb - 3)) & 7);
+	return 8*(msb - 2) + sub;
+}
+
+static double a3d_workqhist_value(int idx, int upper)
+{
+	if(idx < 8)
+	{
+		return (double) idx;
+	}
+
+	// lower bound or upper bound of the bucket
+	int      shift = idx/8 - 1;
+	uint64_t lower = ((uint64_t) (8 + idx%8)) << shift;
+	uint64_t width = ((uint64_t) 1) << shift;
+	if(upper)
+	{
+		return (double) (lower + width - 1);
+	}
+	return (double) lower + 0.5*((double) (width - 1));
+}
+
+static void
+a3d_workqhist_inc(uint64_t* counter, uint64_t value)
+{
+	// counters have a single writer so a relaxed load and
+	// store is sufficient for the concurrent readers
+	__atomic_store_n(counter,
+	                 __atomic_load_n(counter, __ATOMIC_RELAXED) + value,
+	                 __ATOMIC_RELAXED);
+}
+
+static void
+a3d_workqhist_add(a3d_workqhist_t* self, uint64_t value)
+{
+	assert(self);
+
+	a3d_workqhist_inc(&self->bucket[a3d_workqhist_index(value)], 1);
+	a3d_workqhist_inc(&self->count, 1);
+	a3d_workqhist_inc(&self->sum, value);
+}
+
+static void
+a3d_workqhist_accum(a3d_workqhist_t* self, a3d_workqhist_t* hist,
+                    a3d_workqhist_t* base)
+{
+	// base may be NULL
+	assert(self);
+	assert(hist);
+
+	// accumulate the difference between hist and base
+	int i;
+	uint64_t v;
+	for(i = 0; i < A3D_WORKQ_HIST_BUCKETS; ++i)
+	{
+		v = __atomic_load_n(&hist->bucket[i], __ATOMIC_RELAXED);
+		self->bucket[i] += base ? v - base->bucket[i] : v;
+	}
+	v = __atomic_load_n(&hist->count, __ATOMIC_RELAXED);
+	self->count += base ? v - base->count : v;
+	v = __atomic_load_n(&hist->sum, __ATOMIC_RELAXED);
+	self->sum += base ? v - base->sum : v;
+}
+
+static void
+a3d_workqhist_dist(a3d_workqhist_t* self, double scale,
+                   a3d_workqdist_t* dist)
+{
+	assert(self);
+	assert(dist);
+
+	memset(dist, 0, sizeof(a3d_workqdist_t));
+	if(self->count == 0)
+	{
+		return;
+	}
+
+	dist->count = self->count;
+	dist->mean  = scale*((double) self->sum)/((double) self->count);
+
+	// the buckets are summed rather than using count since
+	// the worker may update them between loads
+	int      i;
+	uint64_t total = 0;
+	for(i = 0; i < A3D_WORKQ_HIST_BUCKETS; ++i)
+	{
+		total += self->bucket[i];
+	}
+
+	// nearest rank percentiles
+	uint64_t r50 = (50*total + 99)/100;
+	uint64_t r95 = (95*total + 99)/100;
+	uint64_t r99 = (99*total + 99)/100;
+	uint64_t n   = 0;
+	for(i = 0; i < A3D_WORKQ_HIST_BUCKETS; ++i)
+	{
+		if(self->bucket[i] == 0)
+		{
+			continue;
+		}
+
+		uint64_t m = n;
+		n += self->bucket[i];
+		if((m < r50) && (n >= r50))
+		{
+			dist->p50 = scale*a3d_workqhist_value(i, 0);
+		}
+		if((m < r95) && (n >= r95))
+		{
+			dist->p95 = scale*a3d_workqhist_value(i, 0);
+		}
+		if((m < r99) && (n >= r99))
+		{
+			dist->p99 = scale*a3d_workqhist_value(i, 0);
+		}
+		dist->max = scale*a3d_workqhist_value(i, 1);
+	}
+}
+
+static uint64_t a3d_workq_now(uint64_t* _t)
+{
+	assert(_t);
+
+	// sample the clock at most once per call into the workq
+	if(*_t == 0)
+	{
+		*_t = a3d_timestamp_ns();
+	}
+	return *_t;
+}
+
+static void
+a3d_workq_statsStart(a3d_workq_t* self, int tid,
+                     a3d_workqnode_t* node, uint64_t t)
+{
+	assert(self);
+	assert(node);
+
+	a3d_workqhist_add(&self->stats_thread[tid].wait,
+	                  t - node->t_enqueue);
+}
+
+static void
+a3d_workq_statsRun(a3d_workq_t* self, int tid,
+                   a3d_workqnode_t* node, uint64_t t0)
+{
+	assert(self);
+	assert(node);
+
+	uint64_t t1 = a3d_timestamp_ns();
+	a3d_workqcounters_t* counters = &self->stats_thread[tid];
+	a3d_workqhist_add(&counters->run, t1 - t0);
+	a3d_workqhist_inc(&counters->busy, t1 - t0);
+	node->t_complete = t1;
+}
+
+static void
+a3d_workq_statsCollect(a3d_workq_t* self, a3d_workqnode_t* node,
+                       uint64_t* _t)
+{
+	assert(self);
+	assert(node);
+	assert(_t);
+
+	// only the first collect of a node is recorded
+	if(node->t_complete)
+	{
+		uint64_t t = a3d_workq_now(_t);
+		a3d_workqhist_add(&self->stats_collect,
+		                  t - node->t_complete);
+		node->t_complete = 0;
+	}
+}
+
+static a3d_workqnode_t*
+a3d_workq_find(a3d_workq_t* self, void* task)
+{
+	assert(self);
+	assert(task);
+
+	// the index replaces searching each queue
+	a3d_intmapIter_t iter;
+	return (a3d_workqnode_t*)
+	       a3d_intmap_find(self->index, &iter,
+	                       (uint64_t) (uintptr_t) task);
+}
+
+static void
+a3d_workq_unindex(a3d_workq_t* self, void* task)
+{
+	assert(self);
+	assert(task);
+
+	a3d_intmapIter_t  iterator;
+	a3d_intmapIter_t* iter = &iterator;
+	if(a3d_intmap_find(self->index, iter,
+	                   (uint64_t) (uintptr_t) task))
+	{
+		a3d_intmap_remove(self->index, &iter);
+	}
+}
+
+static int a3d_workq_queue(a3d_workqnode_t* node)
+{
+	assert(node);
+
+	// work stealing workers move reserved nodes to the
+	// active queue without holding the workq mutex
+	return __atomic_load_n(&node->queue, __ATOMIC_ACQUIRE);
+}
+
+static int
+a3d_workq_before(a3d_workqnode_t* a, a3d_workqnode_t* b)
+{
+	assert(a);
+	assert(b);
+
+	// expired deadlines first (earliest first) then higher
+	// rank and then FIFO
+	if(a->expired != b->expired)
+	{
+		return a->expired > b->expired;
+	}
+	else if(a->expired && (a->deadline != b->deadline))
+	{
+		return a->deadline < b->deadline;
+	}
+	else if(a->rank != b->rank)
+	{
+		return a->rank > b->rank;
+	}
+	return a->seq < b->seq;
+}
+
+static void
+a3d_workq_rank(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	// the aged priority at time t is
+	// priority + (t - t_enqueue)/aging
+	// so ordering by priority*aging - t_enqueue is the same
+	// for any t and the heap remains valid as nodes age
+	if(self->aging)
+	{
+		node->rank = ((int64_t) node->priority)*
+		             ((int64_t) self->aging) -
+		             ((int64_t) node->t_enqueue);
+	}
+	else
+	{
+		node->rank = node->priority;
+	}
+}
+
+static void
+a3d_workq_deadline(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	if((node->deadline == 0) || node->expired)
+	{
+		return;
+	}
+
+	if((self->deadline_next == 0) ||
+	   (node->deadline < self->deadline_next))
+	{
+		self->deadline_next = node->deadline;
+	}
+}
+
+static void
+a3d_workq_heapUp(a3d_workq_t* self, int idx)
+{
+	assert(self);
+
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+
+	a3d_workqnode_t* node = heap[idx];
+	while(idx > 0)
+	{
+		int parent = (idx - 1)/2;
+		if(a3d_workq_before(node, heap[parent]) == 0)
+		{
+			break;
+		}
+
+		heap[idx] = heap[parent];
+		heap[idx]->heap_idx = idx;
+		idx = parent;
+	}
+	heap[idx]      = node;
+	node->heap_idx = idx;
+}
+
+static void
+a3d_workq_heapDown(a3d_workq_t* self, int idx)
+{
+	assert(self);
+
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+
+	int size = a3d_array_size(self->queue_pending);
+	a3d_workqnode_t* node = heap[idx];
+	while(1)
+	{
+		int child = 2*idx + 1;
+		if(child >= size)
+		{
+			break;
+		}
+
+		if((child + 1 < size) &&
+		   a3d_workq_before(heap[child + 1], heap[child]))
+		{
+			++child;
+		}
+
+		if(a3d_workq_before(heap[child], node) == 0)
+		{
+			break;
+		}
+
+		heap[idx] = heap[child];
+		heap[idx]->heap_idx = idx;
+		idx = child;
+	}
+	heap[idx]      = node;
+	node->heap_idx = idx;
+}
+
+static int
+a3d_workq_heapInsert(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	// new and reprioritized nodes follow the pending nodes
+	// of the same priority
+	node->seq = self->seq++;
+	a3d_workq_rank(self, node);
+	if(a3d_array_push(self->queue_pending,
+	                  (const void*) &node) == 0)
+	{
+		return 0;
+	}
+
+	a3d_workq_heapUp(self, a3d_array_size(self->queue_pending) - 1);
+	a3d_workq_deadline(self, node);
+	return 1;
+}
+
+static void
+a3d_workq_heapRemove(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+	assert(node->heap_idx >= 0);
+
+	// replace the node with the last node
+	int idx = node->heap_idx;
+	a3d_workqnode_t* last;
+	a3d_array_pop(self->queue_pending, (void*) &last);
+	node->heap_idx = -1;
+	if(last == node)
+	{
+		return;
+	}
+
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+	heap[idx]      = last;
+	last->heap_idx = idx;
+	a3d_workq_heapUp(self, idx);
+	a3d_workq_heapDown(self, last->heap_idx);
+}
+
+static void
+a3d_workq_heapUpdate(a3d_workq_t* self, a3d_workqnode_t* node,
+                     int priority)
+{
+	assert(self);
+	assert(node);
+	assert(node->heap_idx >= 0);
+
+	node->priority = priority;
+	node->seq      = self->seq++;
+	a3d_workq_rank(self, node);
+	a3d_workq_heapUp(self, node->heap_idx);
+	a3d_workq_heapDown(self, node->heap_idx);
+}
+
+static void a3d_workq_heapBuild(a3d_workq_t* self)
+{
+	assert(self);
+
+	// restore the heap after the nodes were compacted or
+	// reranked
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+
+	int size = a3d_array_size(self->queue_pending);
+	int i;
+	for(i = 0; i < size; ++i)
+	{
+		heap[i]->heap_idx = i;
+	}
+	for(i = size/2 - 1; i >= 0; --i)
+	{
+		a3d_workq_heapDown(self, i);
+	}
+}
+
+static void a3d_workq_wake(a3d_workq_t* self, int count);
+
+static int
+a3d_workq_link(a3d_workqnode_t* node, a3d_workqnode_t* prereq)
+{
+	assert(node);
+	assert(prereq);
+
+	// ignore duplicate prerequisites
+	int i;
+	for(i = 0; node->prereqs &&
+	           (i < a3d_array_size(node->prereqs)); ++i)
+	{
+		if(*((a3d_workqnode_t**) a3d_array_get(node->prereqs, i)) ==
+		   prereq)
+		{
+			return 1;
+		}
+	}
+
+	if(node->prereqs == NULL)
+	{
+		node->prereqs = a3d_array_new(sizeof(a3d_workqnode_t*));
+		if(node->prereqs == NULL)
+		{
+			return 0;
+		}
+	}
+
+	if(prereq->dependents == NULL)
+	{
+		prereq->dependents = a3d_array_new(sizeof(a3d_workqnode_t*));
+		if(prereq->dependents == NULL)
+		{
+			return 0;
+		}
+	}
+
+	if(a3d_array_push(node->prereqs, (const void*) &prereq) == 0)
+	{
+		return 0;
+	}
+
+	if(a3d_array_push(prereq->dependents, (const void*) &node) == 0)
+	{
+		a3d_array_pop(node->prereqs, NULL);
+		return 0;
+	}
+
+	return 1;
+}
+
+static void
+a3d_workq_unlinkEdge(a3d_array_t* edges, a3d_workqnode_t* node)
+{
+	assert(edges);
+	assert(node);
+
+	// replace the edge with the last edge
+	a3d_workqnode_t** data;
+	data = (a3d_workqnode_t**) a3d_array_data(edges);
+
+	int size = a3d_array_size(edges);
+	int i;
+	for(i = 0; i < size; ++i)
+	{
+		if(data[i] == node)
+		{
+			data[i] = data[size - 1];
+			a3d_array_pop(edges, NULL);
+			return;
+		}
+	}
+}
+
+static void a3d_workq_unlinkPrereqs(a3d_workqnode_t* node)
+{
+	assert(node);
+
+	// remove the edges from the prerequisites
+	int i;
+	for(i = 0; node->prereqs &&
+	           (i < a3d_array_size(node->prereqs)); ++i)
+	{
+		a3d_workqnode_t* prereq;
+		prereq = *((a3d_workqnode_t**)
+		           a3d_array_get(node->prereqs, i));
+		a3d_workq_unlinkEdge(prereq->dependents, node);
+	}
+	a3d_array_delete(&node->prereqs);
+}
+
+static void a3d_workq_unlink(a3d_workqnode_t* node)
+{
+	assert(node);
+
+	// remove the edges to and from the node
+	a3d_workq_unlinkPrereqs(node);
+
+	int i;
+	for(i = 0; node->dependents &&
+	           (i < a3d_array_size(node->dependents)); ++i)
+	{
+		a3d_workqnode_t* dependent;
+		dependent = *((a3d_workqnode_t**)
+		              a3d_array_get(node->dependents, i));
+		a3d_workq_unlinkEdge(dependent->prereqs, node);
+	}
+	a3d_array_delete(&node->dependents);
+}
+
+static void
+a3d_workq_touch(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	// running a blocked task again keeps its prerequisites
+	// from being purged
+	int i;
+	for(i = 0; node->prereqs &&
+	           (i < a3d_array_size(node->prereqs)); ++i)
+	{
+		a3d_workqnode_t* prereq;
+		prereq = *((a3d_workqnode_t**)
+		           a3d_array_get(node->prereqs, i));
+		if((prereq->epoch != self->epoch) &&
+		   (prereq->epoch != A3D_WORKQ_PURGE))
+		{
+			prereq->epoch = self->epoch;
+			a3d_workq_touch(self, prereq);
+		}
+	}
+}
+
+static void
+a3d_workq_mark(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	// mark the dependents of a purged node for purge
+	int i;
+	for(i = 0; node->dependents &&
+	           (i < a3d_array_size(node->dependents)); ++i)
+	{
+		a3d_workqnode_t* dependent;
+		dependent = *((a3d_workqnode_t**)
+		              a3d_array_get(node->dependents, i));
+		if(dependent->epoch != A3D_WORKQ_PURGE)
+		{
+			dependent->epoch = A3D_WORKQ_PURGE;
+			a3d_workq_mark(self, dependent);
+		}
+	}
+}
+
+static void
+a3d_workq_unblock(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	// the dependents remain linked
+	a3d_workq_unlinkPrereqs(node);
+	a3d_list_removeItem(self->queue_blocked, &node->item);
+	__atomic_sub_fetch(&self->blocked_count, 1, __ATOMIC_SEQ_CST);
+}
+
+static void
+a3d_workq_drop(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	// purge the blocked dependents of a cancelled or purged
+	// node which can no longer run
+	while(node->dependents && a3d_array_size(node->dependents))
+	{
+		a3d_workqnode_t* dependent;
+		dependent = *((a3d_workqnode_t**)
+		              a3d_array_peektail(node->dependents));
+		a3d_workq_drop(self, dependent);
+		a3d_workq_unblock(self, dependent);
+		a3d_workq_unindex(self, dependent->task);
+		(*self->purge_fn)(self->owner, dependent->task,
+		                  dependent->status);
+		a3d_workqnode_delete(&dependent);
+	}
+}
+
+static void
+a3d_workq_release(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	if(node->dependents == NULL)
+	{
+		return;
+	}
+
+	// dependents of a failed or cancelled node also fail
+	// rather than run without the result
+	int failed = (node->status != A3D_WORKQ_COMPLETE) ||
+	             __atomic_load_n(&node->cancel, __ATOMIC_ACQUIRE);
+
+	int      wake = 0;
+	uint64_t t    = 0;
+	while(a3d_array_size(node->dependents))
+	{
+		a3d_workqnode_t* dependent;
+		a3d_array_pop(node->dependents, (void*) &dependent);
+		a3d_workq_unlinkEdge(dependent->prereqs, node);
+		if((failed == 0) && a3d_array_size(dependent->prereqs))
+		{
+			continue;
+		}
+
+		a3d_workq_unblock(self, dependent);
+		if(failed == 0)
+		{
+			// the wait for a dependent starts once the
+			// prerequisites complete
+			dependent->t_enqueue = a3d_workq_now(&t);
+			dependent->queue     = A3D_WORKQ_QUEUE_PENDING;
+			if(a3d_workq_heapInsert(self, dependent))
+			{
+				++wake;
+				continue;
+			}
+		}
+
+		// put the failed dependent on the complete queue
+		dependent->status = A3D_WORKQ_ERROR;
+		dependent->queue  = A3D_WORKQ_QUEUE_COMPLETE;
+		a3d_list_appendItem(self->queue_complete, NULL,
+		                    &dependent->item,
+		                    (const void*) dependent);
+		a3d_workq_release(self, dependent);
+	}
+	a3d_array_delete(&node->dependents);
+
+	a3d_workq_wake(self, wake);
+}
+
+static a3d_workqnode_t**
+a3d_workqdeque_slot(a3d_workqdeque_t* self, int i)
+{
+	assert(self);
+
+	return &self->nodes[(self->head + i)%A3D_WORKQ_DEQUE_SIZE];
+}
+
+static void
+a3d_workqdeque_remove(a3d_workqdeque_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	int i;
+	int j = 0;
+	for(i = 0; i < self->count; ++i)
+	{
+		a3d_workqnode_t* tmp = *a3d_workqdeque_slot(self, i);
+		if(tmp != node)
+		{
+			*a3d_workqdeque_slot(self, j) = tmp;
+			++j;
+		}
+	}
+	self->count = j;
+}
+
+static a3d_workqnode_t*
+a3d_workq_take(a3d_workq_t* self, int tid)
+{
+	assert(self);
+
+	// take the head of the local deque or steal the tail
+	// of another deque
+	int i;
+	for(i = 0; i < self->thread_count; ++i)
+	{
+		a3d_workqdeque_t* deque;
+		deque = &self->deques[(tid + i)%self->thread_count];
+		pthread_mutex_lock(&deque->mutex);
+		if(deque->count == 0)
+		{
+			pthread_mutex_unlock(&deque->mutex);
+			continue;
+		}
+
+		a3d_workqnode_t* node;
+		if(i == 0)
+		{
+			node = *a3d_workqdeque_slot(deque, 0);
+			deque->head = (deque->head + 1)%A3D_WORKQ_DEQUE_SIZE;
+		}
+		else
+		{
+			node = *a3d_workqdeque_slot(deque, deque->count - 1);
+		}
+		--deque->count;
+
+		__atomic_add_fetch(&self->active_count, 1, __ATOMIC_SEQ_CST);
+		__atomic_sub_fetch(&self->reserved_count, 1, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&node->queue, A3D_WORKQ_QUEUE_ACTIVE,
+		                 __ATOMIC_RELEASE);
+		pthread_mutex_unlock(&deque->mutex);
+		return node;
+	}
+
+	return NULL;
+}
+
+static void a3d_workq_reserve(a3d_workq_t* self, int tid)
+{
+	assert(self);
+
+	// reserve a share of the pending nodes which bounds how
+	// far a worker may run ahead of newer high priority tasks
+	int count = a3d_array_size(self->queue_pending)/
+	            self->thread_count;
+	if(count < 1)
+	{
+		count = 1;
+	}
+
+	a3d_workqdeque_t* deque = &self->deques[tid];
+	pthread_mutex_lock(&deque->mutex);
+	if(count > A3D_WORKQ_DEQUE_SIZE - deque->count)
+	{
+		count = A3D_WORKQ_DEQUE_SIZE - deque->count;
+	}
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		a3d_workqnode_t* node;
+		node = *((a3d_workqnode_t**)
+		         a3d_array_get(self->queue_pending, 0));
+		a3d_workq_heapRemove(self, node);
+
+		node->tid = tid;
+		__atomic_store_n(&node->queue, A3D_WORKQ_QUEUE_RESERVED,
+		                 __ATOMIC_RELEASE);
+		*a3d_workqdeque_slot(deque, deque->count) = node;
+		++deque->count;
+	}
+	__atomic_add_fetch(&self->reserved_count, count, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&deque->mutex);
+}
+
+static a3d_workqdeque_t*
+a3d_workq_lockReserved(a3d_workq_t* self, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	// lock the deque of a reserved node so the worker
+	// cannot take the node
+	if(a3d_workq_queue(node) != A3D_WORKQ_QUEUE_RESERVED)
+	{
+		return NULL;
+	}
+
+	a3d_workqdeque_t* deque = &self->deques[node->tid];
+	pthread_mutex_lock(&deque->mutex);
+	if(a3d_workq_queue(node) != A3D_WORKQ_QUEUE_RESERVED)
+	{
+		pthread_mutex_unlock(&deque->mutex);
+		return NULL;
+	}
+
+	return deque;
+}
+
+static void
+a3d_workq_unreserve(a3d_workq_t* self, a3d_workqdeque_t* deque,
+                    a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(deque);
+	assert(node);
+
+	a3d_workqdeque_remove(deque, node);
+	__atomic_sub_fetch(&self->reserved_count, 1, __ATOMIC_SEQ_CST);
+}
+
+static void a3d_workq_collect(a3d_workq_t* self)
+{
+	assert(self);
+
+	if(self->stealing == 0)
+	{
+		return;
+	}
+
+	// reverse the completed list to collect the nodes in
+	// the order they completed
+	a3d_workqnode_t* node;
+	a3d_workqnode_t* next;
+	a3d_workqnode_t* prev = NULL;
+	node = __atomic_exchange_n(&self->completed, NULL,
+	                           __ATOMIC_ACQUIRE);
+	while(node)
+	{
+		next       = node->next;
+		node->next = prev;
+		prev       = node;
+		node       = next;
+	}
+
+	node = prev;
+	while(node)
+	{
+		next       = node->next;
+		node->next = NULL;
+		__atomic_store_n(&node->queue, A3D_WORKQ_QUEUE_COMPLETE,
+		                 __ATOMIC_RELEASE);
+		a3d_list_appendItem(self->queue_complete, NULL,
+		                    &node->item, (const void*) node);
+		__atomic_sub_fetch(&self->active_count, 1, __ATOMIC_SEQ_CST);
+		a3d_workq_release(self, node);
+		node = next;
+	}
+}
+
+static void
+a3d_workq_complete(a3d_workq_t* self, a3d_workqnode_t* node,
+                   int status)
+{
+	assert(self);
+	assert(node);
+
+	// push the node to the completed list
+	node->status = status;
+	a3d_workqnode_t* head;
+	head = __atomic_load_n(&self->completed, __ATOMIC_RELAXED);
+	do
+	{
+		node->next = head;
+	} while(__atomic_compare_exchange_n(&self->completed, &head,
+	                                    node, 1, __ATOMIC_SEQ_CST,
+	                                    __ATOMIC_RELAXED) == 0);
+
+	// only lock the mutex when the main thread is waiting
+	// or to release the blocked nodes which may depend on
+	// the node
+	int blocked = __atomic_load_n(&self->blocked_count,
+	                              __ATOMIC_SEQ_CST);
+	if(blocked ||
+	   (__atomic_load_n(&self->waiters, __ATOMIC_SEQ_CST) > 0))
+	{
+		pthread_mutex_lock(&self->mutex);
+		if(blocked)
+		{
+			a3d_workq_collect(self);
+		}
+		pthread_cond_broadcast(&self->cond_complete);
+		pthread_mutex_unlock(&self->mutex);
+	}
+}
+
+static void a3d_workq_waitComplete(a3d_workq_t* self)
+{
+	assert(self);
+
+	if(self->stealing == 0)
+	{
+		pthread_cond_wait(&self->cond_complete, &self->mutex);
+		return;
+	}
+
+	// workers check for waiters after pushing to the
+	// completed list
+	__atomic_add_fetch(&self->waiters, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&self->completed, __ATOMIC_SEQ_CST) == NULL)
+	{
+		pthread_cond_wait(&self->cond_complete, &self->mutex);
+	}
+	__atomic_sub_fetch(&self->waiters, 1, __ATOMIC_SEQ_CST);
+
+	a3d_workq_collect(self);
+}
+
+static int a3d_workq_active(a3d_workq_t* self)
+{
+	assert(self);
+
+	if(self->stealing)
+	{
+		return __atomic_load_n(&self->active_count,
+		                       __ATOMIC_SEQ_CST);
+	}
+	return a3d_list_size(self->queue_active);
+}
+
+static a3d_workqnode_t* a3d_workq_dequeue(a3d_workq_t* self)
+{
+	assert(self);
+	assert(a3d_array_size(self->queue_pending) > 0);
+
+	// move the next pending node to the active queue
+	a3d_workqnode_t* node;
+	node = *((a3d_workqnode_t**)
+	         a3d_array_get(self->queue_pending, 0));
+	a3d_workq_heapRemove(self, node);
+	a3d_list_appendItem(self->queue_active, NULL,
+	                    &node->item, (const void*) node);
+	node->queue = A3D_WORKQ_QUEUE_ACTIVE;
+
+	return node;
+}
+
+static int
+a3d_workq_execute(a3d_workq_t* self, int tid, a3d_workqnode_t* node)
+{
+	assert(self);
+	assert(node);
+
+	uint64_t t0 = a3d_timestamp_ns();
+	a3d_workq_statsStart(self, tid, node, t0);
+	self->running[tid] = node;
+	int status = (*self->run_fn)(tid, self->owner, node->task);
+	self->running[tid] = NULL;
+	a3d_workq_statsRun(self, tid, node, t0);
+
+	return status;
+}
+
+static void
+a3d_workq_finish(a3d_workq_t* self, a3d_workqnode_t* node,
+                 int status)
+{
+	assert(self);
+	assert(node);
+
+	// put the task on the complete queue
+	node->status = status;
+	node->queue  = A3D_WORKQ_QUEUE_COMPLETE;
+	a3d_list_swapn(self->queue_active, self->queue_complete,
+	               &node->item, NULL);
+	a3d_workq_release(self, node);
+
+	// signal anybody pending for the workq to become idle
+	pthread_cond_signal(&self->cond_complete);
+}
+
+static void* a3d_workq_threadStealing(void* arg)
+{
+	assert(arg);
+	LOGD("debug");
+
+	a3d_workqthread_t* thread = (a3d_workqthread_t*) arg;
+	a3d_workq_t*       self   = thread->workq;
+	int                tid    = thread->tid;
+
+	while(__atomic_load_n(&self->state, __ATOMIC_ACQUIRE) ==
+	      A3D_WORKQ_RUNNING)
+	{
+		a3d_workqnode_t* node = a3d_workq_take(self, tid);
+		if(node)
+		{
+			// run the task
+			int status = a3d_workq_execute(self, tid, node);
+			a3d_workq_complete(self, node, status);
+			continue;
+		}
+
+		pthread_mutex_lock(&self->mutex);
+
+		// pending for an event
+		while((a3d_array_size(self->queue_pending) == 0) &&
+		      (__atomic_load_n(&self->reserved_count,
+		                       __ATOMIC_SEQ_CST) == 0) &&
+		      (self->state == A3D_WORKQ_RUNNING))
+		{
+			pthread_cond_wait(&self->cond_pending, &self->mutex);
+		}
+
+		if(a3d_array_size(self->queue_pending) > 0)
+		{
+			a3d_workq_reserve(self, tid);
+		}
+
+		// wake another thread to share or steal the
+		// remaining nodes
+		if((a3d_array_size(self->queue_pending) > 0) ||
+		   (__atomic_load_n(&self->reserved_count,
+		                    __ATOMIC_SEQ_CST) > 1))
+		{
+			pthread_cond_signal(&self->cond_pending);
+		}
+
+		pthread_mutex_unlock(&self->mutex);
+	}
+
+	return NULL;
+}
+
+static int
+a3d_workq_waitIdle(a3d_workq_t* self, struct timespec* deadline)
+{
+	assert(self);
+	assert(deadline);
+
+	// cond_pending uses the realtime clock
+	if(deadline->tv_sec == 0)
+	{
+		clock_gettime(CLOCK_REALTIME, deadline);
+		uint64_t ns = (uint64_t) deadline->tv_nsec +
+		              self->scale_timeout;
+		deadline->tv_sec  += (time_t) (ns/1000000000ULL);
+		deadline->tv_nsec  = (long) (ns%1000000000ULL);
+	}
+
+	// returns 0 once the idle timeout expires
+	int ret = pthread_cond_timedwait(&self->cond_pending,
+	                                 &self->mutex, deadline);
+	return (ret == ETIMEDOUT) ? 0 : 1;
+}
+
+static void* a3d_workq_thread(void* arg);
+
+static int a3d_workq_spawn(a3d_workq_t* self)
+{
+	assert(self);
+
+	// start a thread in the lowest free slot so the tid
+	// remains bounded by thread_count
+	int i;
+	for(i = 0; i < self->thread_count; ++i)
+	{
+		a3d_workqthread_t* thread = &self->threads[i];
+		if(thread->state == A3D_WORKQ_THREAD_RUNNING)
+		{
+			continue;
+		}
+		else if(thread->state == A3D_WORKQ_THREAD_RETIRED)
+		{
+			// the retired thread no longer needs the mutex
+			pthread_join(thread->thread, NULL);
+			thread->state = A3D_WORKQ_THREAD_NONE;
+		}
+
+		if(pthread_create(&thread->thread, NULL,
+		                  self->stealing ? a3d_workq_threadStealing :
+		                                   a3d_workq_thread,
+		                  (void*) thread) != 0)
+		{
+			LOGE("pthread_create failed");
+			return 0;
+		}
+
+		thread->state = A3D_WORKQ_THREAD_RUNNING;
+		++self->thread_live;
+		return 1;
+	}
+
+	return 0;
+}
+
+static void a3d_workq_grow(a3d_workq_t* self, uint64_t* _t)
+{
+	assert(self);
+	assert(_t);
+
+	// the pool owns the threads of shared workqs
+	if(self->pool)
+	{
+		return;
+	}
+
+	// idle threads will take the pending tasks
+	int pending = a3d_array_size(self->queue_pending);
+	if((pending == 0) || (self->thread_idle > 0) ||
+	   (self->thread_live >= self->thread_count))
+	{
+		return;
+	}
+
+	// add a thread when the backlog or the wait for the
+	// next task exceeds the threshold
+	int grow = (self->thread_live == 0) ||
+	           (pending > self->scale_backlog*self->thread_live);
+	if(grow == 0)
+	{
+		a3d_workqnode_t* node;
+		node = *((a3d_workqnode_t**)
+		         a3d_array_get(self->queue_pending, 0));
+		grow = (a3d_workq_now(_t) - node->t_enqueue) >
+		       self->scale_latency;
+	}
+
+	if(grow)
+	{
+		a3d_workq_spawn(self);
+	}
+}
+
+static void* a3d_workq_thread(void* arg)
+{
+	assert(arg);
+	LOGD("debug");
+
+	a3d_workqthread_t* thread = (a3d_workqthread_t*) arg;
+	a3d_workq_t*       self   = thread->workq;
+	int                tid    = thread->tid;
+	pthread_mutex_lock(&self->mutex);
+
+	while(1)
+	{
+		// pending for an event
+		struct timespec deadline = { .tv_sec = 0, .tv_nsec = 0 };
+		++self->thread_idle;
+		while((a3d_array_size(self->queue_pending) == 0) &&
+		   (self->state == A3D_WORKQ_RUNNING))
+		{
+			if(self->thread_live <= self->thread_min)
+			{
+				pthread_cond_wait(&self->cond_pending,
+				                  &self->mutex);
+			}
+			else if((a3d_workq_waitIdle(self, &deadline) == 0) &&
+			        (self->thread_live > self->thread_min) &&
+			        (a3d_array_size(self->queue_pending) == 0) &&
+			        (self->state == A3D_WORKQ_RUNNING))
+			{
+				// retire the idle thread
+				// other threads may have retired during the wait
+				// and a task submitted as the wait timed out
+				// must be run rather than left without a worker
+				--self->thread_idle;
+				--self->thread_live;
+				thread->state = A3D_WORKQ_THREAD_RETIRED;
+				pthread_mutex_unlock(&self->mutex);
+				return NULL;
+			}
+		}
+		--self->thread_idle;
+
+		if(self->state == A3D_WORKQ_STOP)
+		{
+			// stop condition
+			pthread_mutex_unlock(&self->mutex);
+			return NULL;
+		}
+
+		// get the task
+		a3d_workqnode_t* node = a3d_workq_dequeue(self);
+
+		// wake or add another thread
+		// allows signal instead of broadcast for cond_pending
+		if(a3d_array_size(self->queue_pending) > 0)
+		{
+			uint64_t t = 0;
+			pthread_cond_signal(&self->cond_pending);
+			a3d_workq_grow(self, &t);
+		}
+
+		pthread_mutex_unlock(&self->mutex);
+
+		// run the task
+		int status = a3d_workq_execute(self, tid, node);
+
+		pthread_mutex_lock(&self->mutex);
+		a3d_workq_finish(self, node, status);
+	}
+}
+
+static a3d_workq_t*
+a3d_workq_create(void* owner, int min_threads, int thread_count,
+                 int stealing, a3d_workqrun_fn run_fn,
+                 a3d_workqpurge_fn purge_fn)
+{
+	// owner may be NULL
+	assert((min_threads >= 0) && (min_threads <= thread_count));
+	assert(thread_count > 0);
+	assert((stealing == 0) || (min_threads == thread_count));
+	assert(run_fn);
+	assert(purge_fn);
+	LOGD("debug");
+
+	a3d_workq_t* self = (a3d_workq_t*) malloc(sizeof(a3d_workq_t));
+	if(!self)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->state        = A3D_WORKQ_RUNNING;
+	self->owner        = owner;
+	self->epoch        = 1;
+	self->seq          = 0;
+	self->thread_count = thread_count;
+	self->run_fn       = run_fn;
+	self->purge_fn     = purge_fn;
+
+	self->stealing       = stealing;
+	self->deques         = NULL;
+	self->reserved_count = 0;
+	self->active_count   = 0;
+	self->waiters        = 0;
+	self->completed      = NULL;
+
+	self->stats_t0     = a3d_timestamp_ns();
+	self->stats_thread = NULL;
+	self->stats_base   = NULL;
+	memset(&self->stats_depth, 0, sizeof(a3d_workqhist_t));
+	memset(&self->stats_collect, 0, sizeof(a3d_workqhist_t));
+
+	self->thread_min  = min_threads;
+	self->thread_live = 0;
+	self->thread_idle = 0;
+
+	self->scale_backlog = A3D_WORKQ_SCALE_BACKLOG;
+	self->scale_latency = (uint64_t) (1.0e9*A3D_WORKQ_SCALE_LATENCY);
+	self->scale_timeout = (uint64_t) (1.0e9*A3D_WORKQ_SCALE_TIMEOUT);
+
+	self->aging         = 0;
+	self->expire        = A3D_WORKQ_EXPIRE_PROMOTE;
+	self->deadline_next = 0;
+	self->stats_expired = 0;
+
+	self->pool          = NULL;
+	self->pool_priority = 0;
+	self->pool_weight   = 1;
+	self->pool_pending  = 0;
+	self->pool_synced   = 0;
+	self->pool_busy     = 0;
+	self->pool_vtime    = 0;
+
+	// PTHREAD_MUTEX_DEFAULT is not re-entrant
+	if(pthread_mutex_init(&self->mutex, NULL) != 0)
+	{
+		LOGE("pthread_mutex_init failed");
+		goto fail_mutex_init;
+	}
+
+	if(pthread_cond_init(&self->cond_pending, NULL) != 0)
+	{
+		LOGE("pthread_cond_init failed");
+		goto fail_cond_pending;
+	}
+
+	if(pthread_cond_init(&self->cond_complete, NULL) != 0)
+	{
+		LOGE("pthread_cond_init failed");
+		goto fail_cond_complete;
+	}
+
+	self->queue_pending = a3d_array_new(sizeof(a3d_workqnode_t*));
+	if(self->queue_pending == NULL)
+	{
+		goto fail_queue_pending;
+	}
+
+	// the queue links are embedded in the workq nodes
+	self->queue_complete = a3d_list_newIntrusive();
+	if(self->queue_complete == NULL)
+	{
+		goto fail_queue_complete;
+	}
+
+	self->queue_active = a3d_list_newIntrusive();
+	if(self->queue_active == NULL)
+	{
+		goto fail_queue_active;
+	}
+
+	self->queue_blocked = a3d_list_newIntrusive();
+	if(self->queue_blocked == NULL)
+	{
+		goto fail_queue_blocked;
+	}
+	self->blocked_count = 0;
+
+	self->index = a3d_intmap_new();
+	if(self->index == NULL)
+	{
+		goto fail_index;
+	}
+
+	// alloc deques
+	int d = 0;
+	if(stealing)
+	{
+		self->deques = (a3d_workqdeque_t*)
+		               calloc(thread_count, sizeof(a3d_workqdeque_t));
+		if(self->deques == NULL)
+		{
+			LOGE("calloc failed");
+			goto fail_deques;
+		}
+
+		for(d = 0; d < thread_count; ++d)
+		{
+			if(pthread_mutex_init(&self->deques[d].mutex, NULL) != 0)
+			{
+				LOGE("pthread_mutex_init failed");
+				goto fail_deque_mutex;
+			}
+		}
+	}
+
+	// alloc thread slots
+	self->threads = (a3d_workqthread_t*)
+	                calloc(thread_count, sizeof(a3d_workqthread_t));
+	if(self->threads == NULL)
+	{
+		LOGE("calloc failed");
+		goto fail_threads;
+	}
+
+	int i;
+	for(i = 0; i < thread_count; ++i)
+	{
+		self->threads[i].workq = self;
+		self->threads[i].tid   = i;
+		self->threads[i].state = A3D_WORKQ_THREAD_NONE;
+	}
+
+	// the node run by each thread for a3d_workq_cancelled
+	self->running = (a3d_workqnode_t**)
+	                calloc(thread_count, sizeof(a3d_workqnode_t*));
+	if(self->running == NULL)
+	{
+		LOGE("calloc failed");
+		goto fail_running;
+	}
+
+	// per thread stats and the baseline for statsReset
+	self->stats_thread = (a3d_workqcounters_t*)
+	                     calloc(2*thread_count,
+	                            sizeof(a3d_workqcounters_t));
+	if(self->stats_thread == NULL)
+	{
+		LOGE("calloc failed");
+		goto fail_stats;
+	}
+	self->stats_base = &self->stats_thread[thread_count];
+
+	// create the minimum threads
+	pthread_mutex_lock(&self->mutex);
+	for(i = 0; i < min_threads; ++i)
+	{
+		if(a3d_workq_spawn(self) == 0)
+		{
+			goto fail_pthread_create;
+		}
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	// success
+	return self;
+
+	// fail
+	fail_pthread_create:
+		__atomic_store_n(&self->state, A3D_WORKQ_STOP,
+		                 __ATOMIC_RELEASE);
+		pthread_cond_broadcast(&self->cond_pending);
+		pthread_mutex_unlock(&self->mutex);
+
+		int j;
+		for(j = 0; j < thread_count; ++j)
+		{
+			if(self->threads[j].state != A3D_WORKQ_THREAD_NONE)
+			{
+				pthread_join(self->threads[j].thread, NULL);
+			}
+		}
+		free(self->stats_thread);
+	fail_stats:
+		free(self->running);
+	fail_running:
+		free(self->threads);
+	fail_threads:
+	fail_deque_mutex:
+		{
+			int k;
+			for(k = 0; k < d; ++k)
+			{
+				pthread_mutex_destroy(&self->deques[k].mutex);
+			}
+			free(self->deques);
+		}
+	fail_deques:
+		a3d_intmap_delete(&self->index);
+	fail_index:
+		a3d_list_delete(&self->queue_blocked);
+	fail_queue_blocked:
+		a3d_list_delete(&self->queue_active);
+	fail_queue_active:
+		a3d_list_delete(&self->queue_complete);
+	fail_queue_complete:
+		a3d_array_delete(&self->queue_pending);
+	fail_queue_pending:
+		pthread_cond_destroy(&self->cond_complete);
+	fail_cond_complete:
+		pthread_cond_destroy(&self->cond_pending);
+	fail_cond_pending:
+		pthread_mutex_destroy(&self->mutex);
+	fail_mutex_init:
+		free(self);
+	return NULL;
+}
+
+static int
+a3d_workq_submit(a3d_workq_t* self, void* task, int priority,
+                 uint64_t deadline, int* _wake, uint64_t* _t)
+{
+	assert(self);
+	assert(task);
+	assert(_wake);
+	assert(_t);
+
+	// find the node containing the task or create a new one
+	int status = A3D_WORKQ_ERROR;
+	a3d_listitem_t*   iter  = NULL;
+	a3d_workqnode_t*  node  = a3d_workq_find(self, task);
+	a3d_workqdeque_t* deque = NULL;
+	if(node && (deque = a3d_workq_lockReserved(self, node)))
+	{
+		node->epoch = self->epoch;
+		if(deadline)
+		{
+			node->deadline = deadline;
+			node->expired  = 0;
+		}
+
+		if(priority != node->priority)
+		{
+			// return the node to the pending queue
+			int old = node->priority;
+			node->priority = priority;
+			if(a3d_workq_heapInsert(self, node))
+			{
+				a3d_workq_unreserve(self, deque, node);
+				__atomic_store_n(&node->queue,
+				                 A3D_WORKQ_QUEUE_PENDING,
+				                 __ATOMIC_RELEASE);
+				++(*_wake);
+			}
+			else
+			{
+				node->priority = old;
+			}
+		}
+		pthread_mutex_unlock(&deque->mutex);
+		status = A3D_WORKQ_PENDING;
+	}
+	else if(node && node->cancel &&
+	        (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_COMPLETE))
+	{
+		// reclaim the cancelled task and run it again
+		iter = &node->item;
+		a3d_list_remove(self->queue_complete, &iter);
+		a3d_workq_unindex(self, task);
+		(*self->purge_fn)(self->owner, node->task, node->status);
+		a3d_workqnode_delete(&node);
+		return a3d_workq_submit(self, task, priority, deadline,
+		                        _wake, _t);
+	}
+	else if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_COMPLETE))
+	{
+		// task completed
+		a3d_workq_statsCollect(self, node, _t);
+		iter = &node->item;
+		a3d_list_remove(self->queue_complete, &iter);
+		a3d_workq_unindex(self, task);
+		status = node->status;
+		a3d_workqnode_delete(&node);
+	}
+	else if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_ACTIVE))
+	{
+		node->epoch = self->epoch;
+		status = A3D_WORKQ_PENDING;
+	}
+	else if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_BLOCKED))
+	{
+		// the priority and deadline apply once the
+		// prerequisites complete
+		node->epoch    = self->epoch;
+		node->priority = priority;
+		if(deadline)
+		{
+			node->deadline = deadline;
+			node->expired  = 0;
+		}
+		a3d_workq_touch(self, node);
+		status = A3D_WORKQ_PENDING;
+	}
+	else if(node)
+	{
+		node->epoch = self->epoch;
+
+		// refresh the deadline
+		int expired = node->expired;
+		if(deadline)
+		{
+			node->deadline = deadline;
+			node->expired  = 0;
+			a3d_workq_deadline(self, node);
+		}
+
+		if((priority != node->priority) ||
+		   (expired != node->expired))
+		{
+			// move after the pending nodes of the new priority
+			a3d_workq_heapUpdate(self, node, priority);
+		}
+		status = A3D_WORKQ_PENDING;
+	}
+	else
+	{
+		// create new node
+		node = a3d_workqnode_new(task, self->epoch, priority);
+		if(node == NULL)
+		{
+			return A3D_WORKQ_ERROR;
+		}
+		else if(a3d_intmap_add(self->index, (const void*) node,
+		                       (uint64_t) (uintptr_t) task) == 0)
+		{
+			a3d_workqnode_delete(&node);
+			return A3D_WORKQ_ERROR;
+		}
+
+		// the rank is aged from the enqueue time
+		node->t_enqueue = a3d_workq_now(_t);
+		node->deadline  = deadline;
+		if(a3d_workq_heapInsert(self, node) == 0)
+		{
+			a3d_workq_unindex(self, task);
+			a3d_workqnode_delete(&node);
+			return A3D_WORKQ_ERROR;
+		}
+		else
+		{
+			status = A3D_WORKQ_PENDING;
+
+			// sample the depth including the new node
+			uint64_t depth;
+			depth = a3d_array_size(self->queue_pending) +
+			        __atomic_load_n(&self->reserved_count,
+			                        __ATOMIC_SEQ_CST);
+			a3d_workqhist_add(&self->stats_depth, depth);
+
+			// wake up workq thread
+			++(*_wake);
+		}
+	}
+
+	return status;
+}
+
+static int
+a3d_workq_submitAfter(a3d_workq_t* self, void* task, int priority,
+                      void** deps, int count, int* _wake,
+                      uint64_t* _t)
+{
+	assert(self);
+	assert(task);
+	assert(deps);
+	assert(_wake);
+	assert(_t);
+
+	// a task which is already in the workq keeps its
+	// prerequisites
+	if(a3d_workq_find(self, task))
+	{
+		return a3d_workq_submit(self, task, priority, 0,
+		                        _wake, _t);
+	}
+
+	a3d_workqnode_t* node;
+	node = a3d_workqnode_new(task, self->epoch, priority);
+	if(node == NULL)
+	{
+		return A3D_WORKQ_ERROR;
+	}
+
+	// prerequisites which completed or were collected are
+	// already satisfied
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		a3d_workqnode_t* prereq = a3d_workq_find(self, deps[i]);
+		if((prereq == NULL) ||
+		   (a3d_workq_queue(prereq) == A3D_WORKQ_QUEUE_COMPLETE))
+		{
+			continue;
+		}
+
+		if(a3d_workq_link(node, prereq) == 0)
+		{
+			a3d_workq_unlink(node);
+			a3d_workqnode_delete(&node);
+			return A3D_WORKQ_ERROR;
+		}
+	}
+
+	if(node->prereqs == NULL)
+	{
+		a3d_workqnode_delete(&node);
+		return a3d_workq_submit(self, task, priority, 0,
+		                        _wake, _t);
+	}
+
+	if(a3d_intmap_add(self->index, (const void*) node,
+	                  (uint64_t) (uintptr_t) task) == 0)
+	{
+		a3d_workq_unlink(node);
+		a3d_workqnode_delete(&node);
+		return A3D_WORKQ_ERROR;
+	}
+
+	// the node is blocked until the prerequisites complete
+	// and keeps the prerequisites from being purged
+	node->queue = A3D_WORKQ_QUEUE_BLOCKED;
+	a3d_list_appendItem(self->queue_blocked, NULL,
+	                    &node->item, (const void*) node);
+	__atomic_add_fetch(&self->blocked_count, 1, __ATOMIC_SEQ_CST);
+	a3d_workq_touch(self, node);
+
+	// work stealing workers only release the dependents
+	// of nodes which completed after blocked_count was set
+	a3d_workq_collect(self);
+
+	return A3D_WORKQ_PENDING;
+}
+
+static void a3d_workq_expired(a3d_workq_t* self, uint64_t* _t)
+{
+	assert(self);
+	assert(_t);
+
+	// only scan the pending queue once the earliest deadline
+	// may have passed
+	if((self->deadline_next == 0) ||
+	   (a3d_workq_now(_t) < self->deadline_next))
+	{
+		return;
+	}
+
+	// promote or purge the expired nodes and find the next
+	// deadline of the remaining nodes
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+	int      size = a3d_array_size(self->queue_pending);
+	uint64_t t    = *_t;
+	uint64_t next = 0;
+	int      i;
+	int      j = 0;
+	for(i = 0; i < size; ++i)
+	{
+		a3d_workqnode_t* node = heap[i];
+		if(node->deadline && (node->expired == 0) &&
+		   (node->deadline <= t))
+		{
+			++self->stats_expired;
+			if(self->expire == A3D_WORKQ_EXPIRE_PURGE)
+			{
+				a3d_workq_drop(self, node);
+				a3d_workq_unindex(self, node->task);
+				(*self->purge_fn)(self->owner, node->task,
+				                  node->status);
+				a3d_workqnode_delete(&node);
+				continue;
+			}
+			node->expired = 1;
+		}
+		else if(node->deadline && (node->expired == 0) &&
+		        ((next == 0) || (node->deadline < next)))
+		{
+			next = node->deadline;
+		}
+
+		heap[j] = node;
+		++j;
+	}
+	a3d_array_resize(self->queue_pending, j);
+	a3d_workq_heapBuild(self);
+	self->deadline_next = next;
+}
+
+static void a3d_workq_poolSync(a3d_workq_t* self)
+{
+	assert(self);
+	assert(self->pool);
+
+	// publish the pending count to the pool when it changes
+	// a stale count is corrected when a pool thread finds
+	// the heap empty
+	int pending = a3d_array_size(self->queue_pending);
+	if(pending == self->pool_synced)
+	{
+		return;
+	}
+
+	a3d_workqpool_t* pool = self->pool;
+	pthread_mutex_lock(&pool->mutex);
+	if((self->pool_pending == 0) && (pending > 0))
+	{
+		// an idle queue resumes at the pool virtual time
+		// rather than claiming the time it was idle
+		if(self->pool_vtime < pool->vtime)
+		{
+			self->pool_vtime = pool->vtime;
+		}
+	}
+
+	int wake = pending - self->pool_pending;
+	self->pool_pending = pending;
+	self->pool_synced  = pending;
+	if(wake == 1)
+	{
+		pthread_cond_signal(&pool->cond_pending);
+	}
+	else if(wake > 1)
+	{
+		pthread_cond_broadcast(&pool->cond_pending);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+static void a3d_workq_wake(a3d_workq_t* self, int count)
+{
+	assert(self);
+
+	if(self->pool)
+	{
+		a3d_workq_poolSync(self);
+		return;
+	}
+
+	// a single broadcast wakes the workers for a batch
+	if(count == 1)
+	{
+		pthread_cond_signal(&self->cond_pending);
+	}
+	else if(count > 1)
+	{
+		pthread_cond_broadcast(&self->cond_pending);
+	}
+}
+
+static int
+a3d_workq_remove(a3d_workq_t* self, void* task, int blocking)
+{
+	assert(self);
+	assert(task);
+
+	int status = A3D_WORKQ_ERROR;
+
+	a3d_listitem_t*   iter;
+	a3d_workqnode_t*  node  = a3d_workq_find(self, task);
+	a3d_workqdeque_t* deque = NULL;
+	if(node)
+	{
+		// cancel the dependents which wait for the task
+		a3d_workq_drop(self, node);
+	}
+
+	if(node && (deque = a3d_workq_lockReserved(self, node)))
+	{
+		// cancel reserved task
+		a3d_workq_unreserve(self, deque, node);
+		pthread_mutex_unlock(&deque->mutex);
+		a3d_workq_unindex(self, task);
+		status = node->status;
+		a3d_workqnode_delete(&node);
+	}
+	else if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_PENDING))
+	{
+		// cancel pending task
+		a3d_workq_heapRemove(self, node);
+		a3d_workq_unindex(self, task);
+		status = node->status;
+		a3d_workqnode_delete(&node);
+	}
+	else if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_BLOCKED))
+	{
+		// cancel blocked task
+		a3d_workq_unblock(self, node);
+		a3d_workq_unindex(self, task);
+		status = node->status;
+		a3d_workqnode_delete(&node);
+	}
+	else
+	{
+		if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_ACTIVE))
+		{
+			// request the run_fn to return early
+			__atomic_store_n(&node->cancel, 1, __ATOMIC_RELEASE);
+
+			if(blocking == 0)
+			{
+				// purge_fn reclaims the task once complete
+				node->epoch = A3D_WORKQ_PURGE;
+				return A3D_WORKQ_PENDING;
+			}
+		}
+
+		while(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_ACTIVE))
+		{
+			// must wait for active task to complete
+			a3d_workq_waitComplete(self);
+			node = a3d_workq_find(self, task);
+		}
+
+		if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_COMPLETE))
+		{
+			// cancel completed task
+			iter = &node->item;
+			a3d_list_remove(self->queue_complete, &iter);
+			a3d_workq_unindex(self, task);
+			status = node->status;
+			a3d_workqnode_delete(&node);
+		}
+	}
+
+	// a non-blocking cancel only returns pending when the
+	// task is still running and will be passed to purge_fn
+	if((blocking == 0) && (status == A3D_WORKQ_PENDING))
+	{
+		status = A3D_WORKQ_ERROR;
+	}
+
+	return status;
+}
+
+static void a3d_workq_runShared(a3d_workq_t* self, int tid)
+{
+	assert(self);
+
+	pthread_mutex_lock(&self->mutex);
+
+	// the task may have been cancelled or purged after the
+	// pool selected the workq
+	if(a3d_array_size(self->queue_pending) == 0)
+	{
+		a3d_workq_poolSync(self);
+		pthread_mutex_unlock(&self->mutex);
+		return;
+	}
+
+	a3d_workqnode_t* node = a3d_workq_dequeue(self);
+	a3d_workq_poolSync(self);
+	pthread_mutex_unlock(&self->mutex);
+
+	// run the task
+	int status = a3d_workq_execute(self, tid, node);
+
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_finish(self, node, status);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+static a3d_workq_t* a3d_workqpool_select(a3d_workqpool_t* self)
+{
+	assert(self);
+
+	// select the ready queue with the highest priority and
+	// then the lowest virtual time
+	a3d_workq_t*    workq = NULL;
+	a3d_listitem_t* iter  = a3d_list_head(self->queues);
+	while(iter)
+	{
+		a3d_workq_t* w = (a3d_workq_t*) a3d_list_peekitem(iter);
+		if((w->pool_pending > 0) &&
+		   ((workq == NULL) ||
+		    (w->pool_priority > workq->pool_priority) ||
+		    ((w->pool_priority == workq->pool_priority) &&
+		     (w->pool_vtime < workq->pool_vtime))))
+		{
+			workq = w;
+		}
+		iter = a3d_list_next(iter);
+	}
+
+	if(workq)
+	{
+		// advance the virtual time in inverse proportion to
+		// the weight and reserve the pending task
+		self->vtime = workq->pool_vtime;
+		workq->pool_vtime += A3D_WORKQ_POOL_STRIDE/
+		                     ((uint64_t) workq->pool_weight);
+		--workq->pool_pending;
+		++workq->pool_busy;
+	}
+
+	return workq;
+}
+
+static void* a3d_workqpool_thread(void* arg)
+{
+	assert(arg);
+	LOGD("debug");
+
+	a3d_workqpool_t* self = (a3d_workqpool_t*) arg;
+	pthread_mutex_lock(&self->mutex);
+
+	// checkout the next available thread id
+	int tid = self->next_tid++;
+	while(1)
+	{
+		// pending for an event
+		a3d_workq_t* workq = NULL;
+		while((self->state == A3D_WORKQ_RUNNING) &&
+		      ((workq = a3d_workqpool_select(self)) == NULL))
+		{
+			pthread_cond_wait(&self->cond_pending, &self->mutex);
+		}
+
+		if(self->state == A3D_WORKQ_STOP)
+		{
+			// stop condition
+			pthread_mutex_unlock(&self->mutex);
+			return NULL;
+		}
+
+		pthread_mutex_unlock(&self->mutex);
+		a3d_workq_runShared(workq, tid);
+		pthread_mutex_lock(&self->mutex);
+
+		// signal a workq pending to detach
+		--workq->pool_busy;
+		if(workq->pool_busy == 0)
+		{
+			pthread_cond_broadcast(&self->cond_detach);
+		}
+	}
+}
+
+static int
+a3d_workqpool_attach(a3d_workqpool_t* self, a3d_workq_t* workq)
+{
+	assert(self);
+	assert(workq);
+
+	pthread_mutex_lock(&self->mutex);
+	workq->pool_vtime = self->vtime;
+	int ret = a3d_list_append(self->queues, NULL,
+	                          (const void*) workq) ? 1 : 0;
+	pthread_mutex_unlock(&self->mutex);
+
+	return ret;
+}
+
+static void
+a3d_workqpool_detach(a3d_workqpool_t* self, a3d_workq_t* workq)
+{
+	assert(self);
+	assert(workq);
+
+	pthread_mutex_lock(&self->mutex);
+
+	a3d_listitem_t* iter = a3d_list_head(self->queues);
+	while(iter)
+	{
+		if(a3d_list_peekitem(iter) == (const void*) workq)
+		{
+			a3d_list_remove(self->queues, &iter);
+			break;
+		}
+		iter = a3d_list_next(iter);
 	}
 
-	self->status   = A3D_WORKQ_PENDING;
-	self->priority = priority;
-	self->purge_id = purge_id;
-	self->task     = task;
+	// wait for the pool threads running workq tasks
+	while(workq->pool_busy > 0)
+	{
+		pthread_cond_wait(&self->cond_detach, &self->mutex);
+	}
 
-	return self;
+	pthread_mutex_unlock(&self->mutex);
 }
 
-static void a3d_workqnode_delete(a3d_workqnode_t** _self)
+static void
+a3d_workq_evictBlocked(a3d_workq_t* self, uint64_t epoch)
 {
-	assert(_self);
+	assert(self);
 
-	a3d_workqnode_t* self = *_self;
-	if(self)
+	// only blocked nodes are dependents
+	if(a3d_list_size(self->queue_blocked) == 0)
 	{
-		LOGD("debug");
+		return;
+	}
 
-		free(self);
-		*_self = NULL;
+	// mark the dependents of the purged nodes
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+	int size = a3d_array_size(self->queue_pending);
+	int i;
+	for(i = 0; i < size; ++i)
+	{
+		if(heap[i]->epoch < epoch)
+		{
+			a3d_workq_mark(self, heap[i]);
+		}
 	}
-}
 
-static int a3d_taskcmp_fn(const void *a, const void *b)
-{
-	assert(a);
-	assert(b);
-	LOGD("debug a=%p, b=%p", a, b);
+	int t;
+	for(t = 0; self->deques && (t < self->thread_count); ++t)
+	{
+		a3d_workqdeque_t* deque = &self->deques[t];
+		pthread_mutex_lock(&deque->mutex);
+		for(i = 0; i < deque->count; ++i)
+		{
+			a3d_workqnode_t* node = *a3d_workqdeque_slot(deque, i);
+			if(node->epoch < epoch)
+			{
+				a3d_workq_mark(self, node);
+			}
+		}
+		pthread_mutex_unlock(&deque->mutex);
+	}
+
+	if(self->stealing)
+	{
+		// active nodes are not linked while running
+		a3d_intmapIter_t  iterator;
+		a3d_intmapIter_t* miter;
+		miter = a3d_intmap_head(self->index, &iterator);
+		while(miter)
+		{
+			a3d_workqnode_t* node;
+			node = (a3d_workqnode_t*) a3d_intmap_val(miter);
+			if((a3d_workq_queue(node) == A3D_WORKQ_QUEUE_ACTIVE) &&
+			   (node->epoch < epoch))
+			{
+				a3d_workq_mark(self, node);
+			}
+			miter = a3d_intmap_next(miter);
+		}
+	}
+
+	a3d_listitem_t* iter = a3d_list_head(self->queue_active);
+	while(iter)
+	{
+		a3d_workqnode_t* node;
+		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
+		if(node->epoch < epoch)
+		{
+			a3d_workq_mark(self, node);
+		}
+		iter = a3d_list_next(iter);
+	}
+
+	iter = a3d_list_head(self->queue_blocked);
+	while(iter)
+	{
+		a3d_workqnode_t* node;
+		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
+		if(node->epoch < epoch)
+		{
+			a3d_workq_mark(self, node);
+		}
+		iter = a3d_list_next(iter);
+	}
 
-	a3d_workqnode_t* node = (a3d_workqnode_t*) a;
-	return (node->task == b) ? 0 : 1;
+	// purge the marked and stale blocked nodes
+	// the edges between purged nodes are removed as each
+	// node is deleted
+	iter = a3d_list_head(self->queue_blocked);
+	while(iter)
+	{
+		a3d_workqnode_t* node;
+		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
+		if(node->epoch < epoch)
+		{
+			a3d_list_remove(self->queue_blocked, &iter);
+			__atomic_sub_fetch(&self->blocked_count, 1,
+			                   __ATOMIC_SEQ_CST);
+			a3d_workq_unlink(node);
+			a3d_workq_unindex(self, node->task);
+			(*self->purge_fn)(self->owner, node->task, node->status);
+			a3d_workqnode_delete(&node);
+		}
+		else
+		{
+			iter = a3d_list_next(iter);
+		}
+	}
 }
 
-static void* a3d_workq_thread(void* arg)
+static void a3d_workq_evict(a3d_workq_t* self, uint64_t epoch)
 {
-	assert(arg);
-	LOGD("debug");
+	assert(self);
 
-	a3d_workq_t* self = (a3d_workq_t*) arg;
-	pthread_mutex_lock(&self->mutex);
+	// purge the nodes last run before epoch
+	a3d_workq_collect(self);
 
-	// checkout the next available thread id
-	int tid  = self->next_tid++;
-	while(1)
+	// purge the blocked queue
+	// dependents are purged with their prerequisites
+	a3d_workq_evictBlocked(self, epoch);
+
+	// purge the pending queue
+	// compact the remaining nodes and restore the heap
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+	int size = a3d_array_size(self->queue_pending);
+	int i;
+	int j = 0;
+	for(i = 0; i < size; ++i)
 	{
-		// pending for an event
-		while((a3d_list_size(self->queue_pending) == 0) &&
-		   (self->state == A3D_WORKQ_RUNNING))
+		a3d_workqnode_t* node = heap[i];
+		if(node->epoch < epoch)
 		{
-			pthread_cond_wait(&self->cond_pending, &self->mutex);
+			a3d_workq_unindex(self, node->task);
+			(*self->purge_fn)(self->owner, node->task, node->status);
+			a3d_workqnode_delete(&node);
+		}
+		else
+		{
+			heap[j] = node;
+			++j;
 		}
+	}
+	a3d_array_resize(self->queue_pending, j);
+	a3d_workq_heapBuild(self);
 
-		if(self->state == A3D_WORKQ_STOP)
+	// purge the reserved nodes
+	int t;
+	for(t = 0; self->deques && (t < self->thread_count); ++t)
+	{
+		a3d_workqdeque_t* deque = &self->deques[t];
+		pthread_mutex_lock(&deque->mutex);
+		j = 0;
+		for(i = 0; i < deque->count; ++i)
 		{
-			// stop condition
-			pthread_mutex_unlock(&self->mutex);
-			return NULL;
+			a3d_workqnode_t* node = *a3d_workqdeque_slot(deque, i);
+			if(node->epoch < epoch)
+			{
+				__atomic_sub_fetch(&self->reserved_count, 1,
+				                   __ATOMIC_SEQ_CST);
+				a3d_workq_unindex(self, node->task);
+				(*self->purge_fn)(self->owner, node->task,
+				                  node->status);
+				a3d_workqnode_delete(&node);
+			}
+			else
+			{
+				*a3d_workqdeque_slot(deque, j) = node;
+				++j;
+			}
 		}
+		deque->count = j;
+		pthread_mutex_unlock(&deque->mutex);
+	}
 
-		// get the task
-		a3d_listitem_t*  iter = a3d_list_head(self->queue_pending);
-		a3d_workqnode_t* node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
-		a3d_list_swapn(self->queue_pending, self->queue_active, iter, NULL);
+	// purge the active queue (non-blocking)
+	if(self->stealing)
+	{
+		// active nodes are not linked while running
+		a3d_intmapIter_t  iterator;
+		a3d_intmapIter_t* miter;
+		miter = a3d_intmap_head(self->index, &iterator);
+		while(miter)
+		{
+			a3d_workqnode_t* node;
+			node = (a3d_workqnode_t*) a3d_intmap_val(miter);
+			if((a3d_workq_queue(node) == A3D_WORKQ_QUEUE_ACTIVE) &&
+			   (node->epoch < epoch))
+			{
+				node->epoch = A3D_WORKQ_PURGE;
+			}
+			miter = a3d_intmap_next(miter);
+		}
+	}
 
-		// wake another thread
-		// allows signal instead of broadcast for cond_pending
-		if(a3d_list_size(self->queue_pending) > 0)
+	a3d_listitem_t* iter = a3d_list_head(self->queue_active);
+	while(iter)
+	{
+		a3d_workqnode_t* node;
+		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
+		if(node->epoch < epoch)
 		{
-			pthread_cond_signal(&self->cond_pending);
+			node->epoch = A3D_WORKQ_PURGE;
 		}
+		iter = a3d_list_next(iter);
+	}
 
-		pthread_mutex_unlock(&self->mutex);
+	// purge the complete queue
+	iter = a3d_list_head(self->queue_complete);
+	while(iter)
+	{
+		a3d_workqnode_t* node;
+		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
+		if(node->epoch < epoch)
+		{
+			a3d_list_remove(self->queue_complete, &iter);
+			a3d_workq_unindex(self, node->task);
+			(*self->purge_fn)(self->owner, node->task, node->status);
+			a3d_workqnode_delete(&node);
+		}
+		else
+		{
+			iter = a3d_list_next(iter);
+		}
+	}
+}
 
-		// run the task
-		int status = (*self->run_fn)(tid, self->owner, node->task);
+static int
+a3d_workq_runTask(a3d_workq_t* self, void* task, int priority,
+                  double deadline)
+{
+	assert(self);
+	assert(task);
 
-		pthread_mutex_lock(&self->mutex);
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
+
+	// a negative deadline is none
+	int      wake = 0;
+	uint64_t t    = 0;
+	uint64_t dl   = 0;
+	a3d_workq_expired(self, &t);
+	if(deadline >= 0.0)
+	{
+		dl = a3d_workq_now(&t) + (uint64_t) (1.0e9*deadline);
+	}
 
-		// put the task on the complete queue
-		node->status = status;
-		a3d_list_swapn(self->queue_active, self->queue_complete, iter, NULL);
+	int status = a3d_workq_submit(self, task, priority, dl,
+	                              &wake, &t);
+	a3d_workq_wake(self, wake);
+	a3d_workq_grow(self, &t);
 
-		// signal anybody pending for the workq to become idle
-		pthread_cond_signal(&self->cond_complete);
-	}
+	pthread_mutex_unlock(&self->mutex);
+
+	return status;
 }
 
 /***********************************************************
 * public                                                   *
 ***********************************************************/
 
-a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
-                           a3d_workqrun_fn run_fn,
-                           a3d_workqpurge_fn purge_fn)
+a3d_workqpool_t* a3d_workqpool_new(int thread_count)
 {
-	// owner may be NULL
-	assert(run_fn);
-	assert(purge_fn);
-	LOGD("debug");
+	// track the core count by default
+	if(thread_count <= 0)
+	{
+		thread_count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+		if(thread_count <= 0)
+		{
+			thread_count = 1;
+		}
+	}
+	LOGD("debug thread_count=%i", thread_count);
 
-	a3d_workq_t* self = (a3d_workq_t*) malloc(sizeof(a3d_workq_t));
-	if(!self)
+	a3d_workqpool_t* self;
+	self = (a3d_workqpool_t*) malloc(sizeof(a3d_workqpool_t));
+	if(self == NULL)
 	{
 		LOGE("malloc failed");
 		return NULL;
 	}
 
 	self->state        = A3D_WORKQ_RUNNING;
-	self->owner        = owner;
-	self->purge_id     = 0;
 	self->thread_count = thread_count;
 	self->next_tid     = 0;
-	self->run_fn       = run_fn;
-	self->purge_fn     = purge_fn;
+	self->vtime        = 0;
 
-	// PTHREAD_MUTEX_DEFAULT is not re-entrant
 	if(pthread_mutex_init(&self->mutex, NULL) != 0)
 	{
 		LOGE("pthread_mutex_init failed");
@@ -182,33 +2424,20 @@ a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
 		goto fail_cond_pending;
 	}
 
-	if(pthread_cond_init(&self->cond_complete, NULL) != 0)
+	if(pthread_cond_init(&self->cond_detach, NULL) != 0)
 	{
 		LOGE("pthread_cond_init failed");
-		goto fail_cond_complete;
-	}
-
-	self->queue_pending = a3d_list_new();
-	if(self->queue_pending == NULL)
-	{
-		goto fail_queue_pending;
+		goto fail_cond_detach;
 	}
 
-	self->queue_complete = a3d_list_new();
-	if(self->queue_complete == NULL)
-	{
-		goto fail_queue_complete;
-	}
-
-	self->queue_active = a3d_list_new();
-	if(self->queue_active == NULL)
+	self->queues = a3d_list_new();
+	if(self->queues == NULL)
 	{
-		goto fail_queue_active;
+		goto fail_queues;
 	}
 
-	// alloc threads
-	int sz = thread_count*sizeof(pthread_t);
-	self->threads = (pthread_t*) malloc(sz);
+	self->threads = (pthread_t*)
+	                malloc(thread_count*sizeof(pthread_t));
 	if(self->threads == NULL)
 	{
 		LOGE("malloc failed");
@@ -221,7 +2450,8 @@ a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
 	for(i = 0; i < thread_count; ++i)
 	{
 		if(pthread_create(&(self->threads[i]), NULL,
-		                  a3d_workq_thread, (void*) self) != 0)
+		                  a3d_workqpool_thread,
+		                  (void*) self) != 0)
 		{
 			LOGE("pthread_create failed");
 			goto fail_pthread_create;
@@ -232,9 +2462,10 @@ a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
 	// success
 	return self;
 
-	// fail
+	// failure
 	fail_pthread_create:
 		self->state = A3D_WORKQ_STOP;
+		pthread_cond_broadcast(&self->cond_pending);
 		pthread_mutex_unlock(&self->mutex);
 
 		int j;
@@ -244,14 +2475,10 @@ a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
 		}
 		free(self->threads);
 	fail_threads:
-		a3d_list_delete(&self->queue_active);
-	fail_queue_active:
-		a3d_list_delete(&self->queue_complete);
-	fail_queue_complete:
-		a3d_list_delete(&self->queue_pending);
-	fail_queue_pending:
-		pthread_cond_destroy(&self->cond_complete);
-	fail_cond_complete:
+		a3d_list_delete(&self->queues);
+	fail_queues:
+		pthread_cond_destroy(&self->cond_detach);
+	fail_cond_detach:
 		pthread_cond_destroy(&self->cond_pending);
 	fail_cond_pending:
 		pthread_mutex_destroy(&self->mutex);
@@ -260,6 +2487,117 @@ a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
 	return NULL;
 }
 
+void a3d_workqpool_delete(a3d_workqpool_t** _self)
+{
+	// *_self can be null
+	assert(_self);
+
+	a3d_workqpool_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		// the workqs must be deleted before the pool
+		assert(a3d_list_size(self->queues) == 0);
+
+		pthread_mutex_lock(&self->mutex);
+		self->state = A3D_WORKQ_STOP;
+		pthread_cond_broadcast(&self->cond_pending);
+		pthread_mutex_unlock(&self->mutex);
+
+		int i;
+		for(i = 0; i < self->thread_count; ++i)
+		{
+			pthread_join(self->threads[i], NULL);
+		}
+		free(self->threads);
+
+		a3d_list_delete(&self->queues);
+		pthread_cond_destroy(&self->cond_detach);
+		pthread_cond_destroy(&self->cond_pending);
+		pthread_mutex_destroy(&self->mutex);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
+                           a3d_workqrun_fn run_fn,
+                           a3d_workqpurge_fn purge_fn)
+{
+	// owner may be NULL
+	assert(run_fn);
+	assert(purge_fn);
+
+	return a3d_workq_create(owner, thread_count, thread_count,
+	                        0, run_fn, purge_fn);
+}
+
+a3d_workq_t* a3d_workq_newStealing(void* owner, int thread_count,
+                                   a3d_workqrun_fn run_fn,
+                                   a3d_workqpurge_fn purge_fn)
+{
+	// owner may be NULL
+	assert(run_fn);
+	assert(purge_fn);
+
+	// workers reserve batches of pending tasks in per thread
+	// deques, steal from other deques when idle and complete
+	// tasks without locking the workq mutex
+	return a3d_workq_create(owner, thread_count, thread_count,
+	                        1, run_fn, purge_fn);
+}
+
+a3d_workq_t* a3d_workq_newShared(void* owner,
+                                 a3d_workqpool_t* pool,
+                                 int priority, int weight,
+                                 a3d_workqrun_fn run_fn,
+                                 a3d_workqpurge_fn purge_fn)
+{
+	// owner may be NULL
+	assert(pool);
+	assert(weight > 0);
+	assert(run_fn);
+	assert(purge_fn);
+
+	// the workq has no threads of its own and the tid passed
+	// to run_fn is the pool thread id
+	a3d_workq_t* self;
+	self = a3d_workq_create(owner, 0, pool->thread_count,
+	                        0, run_fn, purge_fn);
+	if(self == NULL)
+	{
+		return NULL;
+	}
+
+	self->pool          = pool;
+	self->pool_priority = priority;
+	self->pool_weight   = weight;
+	if(a3d_workqpool_attach(pool, self) == 0)
+	{
+		self->pool = NULL;
+		a3d_workq_delete(&self);
+		return NULL;
+	}
+
+	return self;
+}
+
+a3d_workq_t* a3d_workq_newDynamic(void* owner, int min_threads,
+                                  int max_threads,
+                                  a3d_workqrun_fn run_fn,
+                                  a3d_workqpurge_fn purge_fn)
+{
+	// owner may be NULL
+	assert(run_fn);
+	assert(purge_fn);
+
+	// threads are added on demand up to max_threads and
+	// retire when idle down to min_threads
+	return a3d_workq_create(owner, min_threads, max_threads,
+	                        0, run_fn, purge_fn);
+}
+
 void a3d_workq_delete(a3d_workq_t** _self)
 {
 	// *_self can be null
@@ -270,26 +2608,55 @@ void a3d_workq_delete(a3d_workq_t** _self)
 	{
 		LOGD("debug");
 
+		// stop the pool from running tasks
+		if(self->pool)
+		{
+			a3d_workqpool_detach(self->pool, self);
+		}
+
 		pthread_mutex_lock(&self->mutex);
 
 		// stop the workq thread
-		self->state = A3D_WORKQ_STOP;
+		__atomic_store_n(&self->state, A3D_WORKQ_STOP,
+		                 __ATOMIC_RELEASE);
 		pthread_cond_broadcast(&self->cond_pending);
 		pthread_mutex_unlock(&self->mutex);
+		// join the running and retired threads
+		// no threads are added once stopped
 		int i;
 		for(i = 0; i < self->thread_count; ++i)
 		{
-			pthread_join(self->threads[i], NULL);
+			pthread_mutex_lock(&self->mutex);
+			int state = self->threads[i].state;
+			pthread_mutex_unlock(&self->mutex);
+
+			if(state != A3D_WORKQ_THREAD_NONE)
+			{
+				pthread_join(self->threads[i].thread, NULL);
+			}
 		}
+		free(self->stats_thread);
+		free(self->running);
 		free(self->threads);
 
 		// destroy the queues
 		// queue_active will be empty since the threads are stopped
-		self->purge_id = A3D_WORKQ_PURGE;
-		a3d_workq_purge(self);
+		pthread_mutex_lock(&self->mutex);
+		a3d_workq_evict(self, UINT64_MAX);
+		pthread_mutex_unlock(&self->mutex);
+		if(self->deques)
+		{
+			for(i = 0; i < self->thread_count; ++i)
+			{
+				pthread_mutex_destroy(&self->deques[i].mutex);
+			}
+			free(self->deques);
+		}
+		a3d_intmap_delete(&self->index);
+		a3d_list_delete(&self->queue_blocked);
 		a3d_list_delete(&self->queue_active);
 		a3d_list_delete(&self->queue_complete);
-		a3d_list_delete(&self->queue_pending);
+		a3d_array_delete(&self->queue_pending);
 
 		// destroy the thread state
 		pthread_cond_destroy(&self->cond_complete);
@@ -301,35 +2668,82 @@ void a3d_workq_delete(a3d_workq_t** _self)
 	}
 }
 
-void a3d_workq_reset(a3d_workq_t* self, int blocking)
+void a3d_workq_scaling(a3d_workq_t* self, int backlog,
+                       double latency, double timeout)
+{
+	assert(self);
+	assert(backlog > 0);
+	assert(latency >= 0.0);
+	assert(timeout >= 0.0);
+	LOGD("debug backlog=%i, latency=%lf, timeout=%lf",
+	     backlog, latency, timeout);
+
+	// thresholds for a3d_workq_newDynamic
+	pthread_mutex_lock(&self->mutex);
+	self->scale_backlog = backlog;
+	self->scale_latency = (uint64_t) (1.0e9*latency);
+	self->scale_timeout = (uint64_t) (1.0e9*timeout);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void a3d_workq_aging(a3d_workq_t* self, double interval)
+{
+	assert(self);
+	assert(interval >= 0.0);
+	LOGD("debug interval=%lf", interval);
+
+	// rerank the pending nodes for the new interval
+	pthread_mutex_lock(&self->mutex);
+	self->aging = (uint64_t) (1.0e9*interval);
+
+	a3d_workqnode_t** heap;
+	heap = (a3d_workqnode_t**) a3d_array_data(self->queue_pending);
+	int size = a3d_array_size(self->queue_pending);
+	int i;
+	for(i = 0; i < size; ++i)
+	{
+		a3d_workq_rank(self, heap[i]);
+	}
+	a3d_workq_heapBuild(self);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void a3d_workq_expire(a3d_workq_t* self, int expire)
 {
 	assert(self);
+	assert((expire == A3D_WORKQ_EXPIRE_PROMOTE) ||
+	       (expire == A3D_WORKQ_EXPIRE_PURGE));
+	LOGD("debug expire=%i", expire);
+
+	pthread_mutex_lock(&self->mutex);
+	self->expire = expire;
+	pthread_mutex_unlock(&self->mutex);
+}
 
-	// save the purge_id
-	int purge_id = self->purge_id;
+void a3d_workq_reset(a3d_workq_t* self, int blocking)
+{
+	assert(self);
 
 	// purge the pending queue so no new
 	// tasks are submitted to active queue
-	self->purge_id = A3D_WORKQ_PURGE;
-	a3d_workq_purge(self);
+	// the epoch is not advanced
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_evict(self, UINT64_MAX);
 
 	if(blocking)
 	{
 		// blocking wait for the active queue
-		pthread_mutex_lock(&self->mutex);
-		while(a3d_list_size(self->queue_active) > 0)
+		a3d_workq_collect(self);
+		while(a3d_workq_active(self) > 0)
 		{
 			// must wait for active task to complete
-			pthread_cond_wait(&self->cond_complete, &self->mutex);
+			a3d_workq_waitComplete(self);
 		}
-		pthread_mutex_unlock(&self->mutex);
 
 		// purge the complete queue
-		a3d_workq_purge(self);
+		a3d_workq_evict(self, UINT64_MAX);
 	}
-
-	// restore the purge_id
-	self->purge_id = purge_id;
+	pthread_mutex_unlock(&self->mutex);
 }
 
 void a3d_workq_purge(a3d_workq_t* self)
@@ -337,63 +2751,30 @@ void a3d_workq_purge(a3d_workq_t* self)
 	assert(self);
 	LOGD("debug");
 
-	pthread_mutex_lock(&self->mutex);
+	// purge the tasks not run since the last purge
+	a3d_workq_purgeOlderThan(self, 1);
+}
 
-	// purge the pending queue
-	a3d_listitem_t* iter = a3d_list_head(self->queue_pending);
-	while(iter)
-	{
-		a3d_workqnode_t* node;
-		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
-		if(node->purge_id != self->purge_id)
-		{
-			a3d_list_remove(self->queue_pending, &iter);
-			(*self->purge_fn)(self->owner, node->task, node->status);
-			a3d_workqnode_delete(&node);
-		}
-		else
-		{
-			iter = a3d_list_next(iter);
-		}
-	}
+void a3d_workq_purgeOlderThan(a3d_workq_t* self, int epochs)
+{
+	assert(self);
+	assert(epochs > 0);
+	LOGD("debug epochs=%i", epochs);
 
-	// purge the active queue (non-blocking)
-	iter = a3d_list_head(self->queue_active);
-	while(iter)
-	{
-		a3d_workqnode_t* node;
-		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
-		if(node->purge_id != self->purge_id)
-		{
-			node->purge_id = A3D_WORKQ_PURGE;
-		}
-		iter = a3d_list_next(iter);
-	}
+	pthread_mutex_lock(&self->mutex);
 
-	// purge the complete queue
-	iter = a3d_list_head(self->queue_complete);
-	while(iter)
-	{
-		a3d_workqnode_t* node;
-		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
-		if((node->purge_id != self->purge_id) ||
-		   (node->purge_id == A3D_WORKQ_PURGE))
-		{
-			a3d_list_remove(self->queue_complete, &iter);
-			(*self->purge_fn)(self->owner, node->task, node->status);
-			a3d_workqnode_delete(&node);
-		}
-		else
-		{
-			iter = a3d_list_next(iter);
-		}
-	}
+	uint64_t t = 0;
+	a3d_workq_expired(self, &t);
 
-	// swap the purge id
-	if(self->purge_id != A3D_WORKQ_PURGE)
+	// keep the tasks run in the last epochs and advance
+	// the epoch
+	uint64_t epoch = 1;
+	if(self->epoch > (uint64_t) epochs)
 	{
-		self->purge_id = 1 - self->purge_id;
+		epoch = self->epoch - ((uint64_t) epochs) + 1;
 	}
+	a3d_workq_evict(self, epoch);
+	++self->epoch;
 
 	pthread_mutex_unlock(&self->mutex);
 }
@@ -405,151 +2786,176 @@ int a3d_workq_run(a3d_workq_t* self, void* task,
 	assert(task);
 	LOGD("debug task=%p, priority=%i", task, priority);
 
+	return a3d_workq_runTask(self, task, priority, -1.0);
+}
+
+int a3d_workq_runAfter(a3d_workq_t* self, void* task,
+                       int priority, void** deps, int count)
+{
+	assert(self);
+	assert(task);
+	assert(deps || (count == 0));
+	LOGD("debug task=%p, priority=%i, count=%i",
+	     task, priority, count);
+
 	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
 
-	// find the node containing the task or create a new one
-	int status = A3D_WORKQ_ERROR;
-	a3d_listitem_t*  iter = NULL;
-	a3d_listitem_t*  pos  = NULL;
-	a3d_workqnode_t* tmp  = NULL;
-	a3d_workqnode_t* node = NULL;
-	if((iter = a3d_list_find(self->queue_complete, task,
-	                         a3d_taskcmp_fn)) != NULL)
+	int      wake = 0;
+	uint64_t t    = 0;
+	int      status;
+	a3d_workq_expired(self, &t);
+	if(count > 0)
 	{
-		// task completed
-		node = (a3d_workqnode_t*) a3d_list_remove(self->queue_complete,
-		                                          &iter);
-		status = node->status;
-		a3d_workqnode_delete(&node);
+		status = a3d_workq_submitAfter(self, task, priority,
+		                               deps, count, &wake, &t);
 	}
-	else if((iter = a3d_list_find(self->queue_active, task,
-	                              a3d_taskcmp_fn)) != NULL)
+	else
 	{
-		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
-		node->purge_id = self->purge_id;
-		status = A3D_WORKQ_PENDING;
+		status = a3d_workq_submit(self, task, priority, 0,
+		                          &wake, &t);
 	}
-	else if((iter = a3d_list_find(self->queue_pending, task,
-	                              a3d_taskcmp_fn)) != NULL)
-	{
-		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
-		node->purge_id = self->purge_id;
-		if(priority > node->priority)
-		{
-			// move up
-			pos = a3d_list_prev(iter);
-			while(pos)
-			{
-				tmp = (a3d_workqnode_t*) a3d_list_peekitem(pos);
-				if(tmp->priority >= node->priority)
-				{
-					break;
-				}
-				pos = a3d_list_prev(pos);
-			}
+	a3d_workq_wake(self, wake);
+	a3d_workq_grow(self, &t);
 
-			if(pos)
-			{
-				// move after pos
-				a3d_list_moven(self->queue_pending, iter, pos);
-			}
-			else
-			{
-				// move to head of list
-				a3d_list_move(self->queue_pending, iter, NULL);
-			}
-		}
-		else if(priority < node->priority)
-		{
-			// move down
-			pos = a3d_list_next(iter);
-			while(pos)
-			{
-				tmp = (a3d_workqnode_t*) a3d_list_peekitem(pos);
-				if(tmp->priority < node->priority)
-				{
-					break;
-				}
-				pos = a3d_list_next(pos);
-			}
+	pthread_mutex_unlock(&self->mutex);
 
-			if(pos)
-			{
-				// move before pos
-				a3d_list_move(self->queue_pending, iter, pos);
-			}
-			else
-			{
-				// move to tail of list
-				a3d_list_moven(self->queue_pending, iter, NULL);
-			}
+	return status;
+}
+
+int a3d_workq_runDeadline(a3d_workq_t* self, void* task,
+                          int priority, double deadline)
+{
+	assert(self);
+	assert(task);
+	assert(deadline >= 0.0);
+	LOGD("debug task=%p, priority=%i, deadline=%lf",
+	     task, priority, deadline);
+
+	return a3d_workq_runTask(self, task, priority, deadline);
+}
+
+void a3d_workq_runBatch(a3d_workq_t* self, void** tasks,
+                        const int* priorities, int count,
+                        int* status)
+{
+	// status may be NULL
+	assert(self);
+	assert(tasks);
+	assert(priorities);
+	LOGD("debug count=%i", count);
+
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
+
+	int      i;
+	int      wake = 0;
+	uint64_t t    = 0;
+	a3d_workq_expired(self, &t);
+	for(i = 0; i < count; ++i)
+	{
+		int s = a3d_workq_submit(self, tasks[i], priorities[i],
+		                         0, &wake, &t);
+		if(status)
+		{
+			status[i] = s;
 		}
-		node->priority = priority;
-		status = A3D_WORKQ_PENDING;
 	}
-	else
+	a3d_workq_wake(self, wake);
+	a3d_workq_grow(self, &t);
+
+	pthread_mutex_unlock(&self->mutex);
+}
+
+int a3d_workq_drain(a3d_workq_t* self, void** tasks,
+                    int* status, int count)
+{
+	// status may be NULL
+	assert(self);
+	assert(tasks);
+	LOGD("debug count=%i", count);
+
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
+
+	// collect completed tasks in the order they completed
+	// like a3d_workq_run does for a single task
+	// cancelled tasks are left for purge_fn
+	int      i = 0;
+	uint64_t t = 0;
+	a3d_listitem_t* iter = a3d_list_head(self->queue_complete);
+	while(iter && (i < count))
 	{
-		// create new node
-		node = a3d_workqnode_new(task, self->purge_id, priority);
-		if(node == NULL)
+		a3d_workqnode_t* node;
+		node = (a3d_workqnode_t*) a3d_list_peekitem(iter);
+		if(node->cancel)
 		{
-			goto fail_node;
+			iter = a3d_list_next(iter);
+			continue;
 		}
-		else
-		{
-			// find the insert position
-			pos = a3d_list_tail(self->queue_pending);
-			while(pos)
-			{
-				tmp = (a3d_workqnode_t*) a3d_list_peekitem(pos);
-				if(tmp->priority >= node->priority)
-				{
-					break;
-				}
-				pos = a3d_list_prev(pos);
-			}
-
-			if(pos)
-			{
-				// append after pos
-				if(a3d_list_append(self->queue_pending, pos,
-				                   (const void*) node) == NULL)
-				{
-					goto fail_queue;
-				}
-			}
-			else
-			{
-				// insert at head of queue
-				// first item or highest priority
-				if(a3d_list_insert(self->queue_pending, NULL,
-				                   (const void*) node) == NULL)
-				{
-					goto fail_queue;
-				}
-			}
 
-			status = A3D_WORKQ_PENDING;
+		a3d_workq_statsCollect(self, node, &t);
+		a3d_list_remove(self->queue_complete, &iter);
+		a3d_workq_unindex(self, node->task);
 
-			// wake up workq thread
-			pthread_cond_signal(&self->cond_pending);
+		tasks[i] = node->task;
+		if(status)
+		{
+			status[i] = node->status;
 		}
+		a3d_workqnode_delete(&node);
+		++i;
 	}
 
 	pthread_mutex_unlock(&self->mutex);
 
-	// success
+	return i;
+}
+
+int a3d_workq_cancel(a3d_workq_t* self, void* task)
+{
+	assert(self);
+	assert(task);
+	LOGD("debug task=%p", task);
+
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
+	int status = a3d_workq_remove(self, task, 1);
+	pthread_mutex_unlock(&self->mutex);
+
 	return status;
+}
 
-	// failure
-	fail_queue:
-		a3d_workqnode_delete(&node);
-	fail_node:
-		pthread_mutex_unlock(&self->mutex);
-	return A3D_WORKQ_ERROR;
+int a3d_workq_cancelAsync(a3d_workq_t* self, void* task)
+{
+	assert(self);
+	assert(task);
+	LOGD("debug task=%p", task);
+
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
+	int status = a3d_workq_remove(self, task, 0);
+	pthread_mutex_unlock(&self->mutex);
+
+	return status;
 }
 
-int a3d_workq_cancel(a3d_workq_t* self, void* task)
+int a3d_workq_cancelled(a3d_workq_t* self, int tid)
+{
+	assert(self);
+	assert((tid >= 0) && (tid < self->thread_count));
+
+	// called by run_fn so the running node is owned by tid
+	a3d_workqnode_t* node = self->running[tid];
+	if(node == NULL)
+	{
+		return 0;
+	}
+
+	return __atomic_load_n(&node->cancel, __ATOMIC_ACQUIRE);
+}
+
+int a3d_workq_status(a3d_workq_t* self, void* task)
 {
 	assert(self);
 	assert(task);
@@ -557,87 +2963,131 @@ int a3d_workq_cancel(a3d_workq_t* self, void* task)
 
 	int status = A3D_WORKQ_ERROR;
 	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
 
-	a3d_listitem_t* iter;
-	if((iter = a3d_list_find(self->queue_pending, task,
-	                         a3d_taskcmp_fn)) != NULL)
+	// the status of active nodes is written by the workers
+	a3d_workqnode_t* node = a3d_workq_find(self, task);
+	if(node && (a3d_workq_queue(node) == A3D_WORKQ_QUEUE_COMPLETE))
 	{
-		// cancel pending task
-		a3d_workqnode_t* node;
-		node = (a3d_workqnode_t*) a3d_list_remove(self->queue_pending,
-		                                          &iter);
+		uint64_t t = 0;
+		a3d_workq_statsCollect(self, node, &t);
 		status = node->status;
-		a3d_workqnode_delete(&node);
 	}
-	else
+	else if(node)
 	{
-		while((iter = a3d_list_find(self->queue_active, task,
-		                            a3d_taskcmp_fn)) != NULL)
-		{
-			// must wait for active task to complete
-			pthread_cond_wait(&self->cond_complete, &self->mutex);
-		}
-
-		if((iter = a3d_list_find(self->queue_complete, task,
-		                         a3d_taskcmp_fn)) != NULL)
-		{
-			// cancel completed task
-			a3d_workqnode_t* node;
-			node = (a3d_workqnode_t*) a3d_list_remove(self->queue_complete,
-			                                          &iter);
-			status = node->status;
-			a3d_workqnode_delete(&node);
-		}
+		status = A3D_WORKQ_PENDING;
 	}
 
 	pthread_mutex_unlock(&self->mutex);
 	return status;
 }
 
-int a3d_workq_status(a3d_workq_t* self, void* task)
+int a3d_workq_pending(a3d_workq_t* self)
 {
 	assert(self);
-	assert(task);
-	LOGD("debug task=%p");
+	LOGD("debug");
 
-	int status = A3D_WORKQ_ERROR;
+	int size;
 	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
+	size = a3d_array_size(self->queue_pending);
+	size += a3d_workq_active(self);
+	size += __atomic_load_n(&self->reserved_count, __ATOMIC_SEQ_CST);
+	size += a3d_list_size(self->queue_blocked);
+	pthread_mutex_unlock(&self->mutex);
+	return size;
+}
+
+void a3d_workq_stats(a3d_workq_t* self,
+                     a3d_workqstats_t* stats,
+                     double* utilization)
+{
+	// utilization may be NULL
+	assert(self);
+	assert(stats);
+	LOGD("debug");
 
-	a3d_listitem_t* iter;
-	iter = a3d_list_find(self->queue_pending,
-	                     task, a3d_taskcmp_fn);
-	if(iter == NULL)
+	pthread_mutex_lock(&self->mutex);
+	a3d_workq_collect(self);
+
+	stats->pending  = a3d_array_size(self->queue_pending);
+	stats->reserved = __atomic_load_n(&self->reserved_count,
+	                                  __ATOMIC_SEQ_CST);
+	stats->active   = a3d_workq_active(self);
+	stats->complete = a3d_list_size(self->queue_complete);
+	stats->blocked  = a3d_list_size(self->queue_blocked);
+	stats->threads  = self->pool ? self->pool->thread_count :
+	                               self->thread_live;
+	stats->expired  = self->stats_expired;
+
+	uint64_t t = a3d_timestamp_ns();
+	stats->elapsed = ((double) (t - self->stats_t0))/1.0e9;
+
+	// merge the thread counters
+	a3d_workqhist_t wait;
+	a3d_workqhist_t run;
+	memset(&wait, 0, sizeof(a3d_workqhist_t));
+	memset(&run, 0, sizeof(a3d_workqhist_t));
+	int i;
+	for(i = 0; i < self->thread_count; ++i)
 	{
-		iter = a3d_list_find(self->queue_active,
-		                     task, a3d_taskcmp_fn);
-		if(iter == NULL)
+		a3d_workqcounters_t* counters = &self->stats_thread[i];
+		a3d_workqcounters_t* base     = &self->stats_base[i];
+		a3d_workqhist_accum(&wait, &counters->wait, &base->wait);
+		a3d_workqhist_accum(&run, &counters->run, &base->run);
+
+		if(utilization)
 		{
-			iter = a3d_list_find(self->queue_complete,
-			                     task, a3d_taskcmp_fn);
+			uint64_t busy;
+			busy = __atomic_load_n(&counters->busy, __ATOMIC_RELAXED);
+			utilization[i] = 0.0;
+			if(stats->elapsed > 0.0)
+			{
+				utilization[i] = ((double) (busy - base->busy))/
+				                 (1.0e9*stats->elapsed);
+			}
 		}
 	}
 
-	if(iter)
+	a3d_workqhist_dist(&self->stats_depth, 1.0, &stats->depth);
+	a3d_workqhist_dist(&wait, 1.0e-9, &stats->wait);
+	a3d_workqhist_dist(&run, 1.0e-9, &stats->run);
+	a3d_workqhist_dist(&self->stats_collect, 1.0e-9, &stats->collect);
+
+	stats->throughput = 0.0;
+	if(stats->elapsed > 0.0)
 	{
-		a3d_workqnode_t* node;
-		node = (a3d_workqnode_t*)
-		       a3d_list_peekitem(iter);
-		status = node->status;
+		stats->throughput = ((double) run.count)/stats->elapsed;
 	}
 
 	pthread_mutex_unlock(&self->mutex);
-	return status;
 }
 
-int a3d_workq_pending(a3d_workq_t* self)
+void a3d_workq_statsReset(a3d_workq_t* self)
 {
 	assert(self);
 	LOGD("debug");
 
-	int size;
 	pthread_mutex_lock(&self->mutex);
-	size = a3d_list_size(self->queue_pending);
-	size += a3d_list_size(self->queue_active);
+
+	self->stats_t0      = a3d_timestamp_ns();
+	self->stats_expired = 0;
+	memset(&self->stats_depth, 0, sizeof(a3d_workqhist_t));
+	memset(&self->stats_collect, 0, sizeof(a3d_workqhist_t));
+
+	// the workers may be updating their counters so take a
+	// snapshot to compare with
+	int i;
+	for(i = 0; i < self->thread_count; ++i)
+	{
+		a3d_workqcounters_t* counters = &self->stats_thread[i];
+		a3d_workqcounters_t* base     = &self->stats_base[i];
+		memset(base, 0, sizeof(a3d_workqcounters_t));
+		a3d_workqhist_accum(&base->wait, &counters->wait, NULL);
+		a3d_workqhist_accum(&base->run, &counters->run, NULL);
+		base->busy = __atomic_load_n(&counters->busy,
+		                             __ATOMIC_RELAXED);
+	}
+
 	pthread_mutex_unlock(&self->mutex);
-	return size;
 }
@@ -25,6 +25,8 @@
 #define a3d_workq_H
 
 #include "a3d_list.h"
+#include "a3d_array.h"
+#include "a3d_intmap.h"
 #include <pthread.h>
 
 // task status
@@ -32,6 +34,10 @@
 #define A3D_WORKQ_COMPLETE 1
 #define A3D_WORKQ_PENDING  2
 
+// expired deadline policy
+#define A3D_WORKQ_EXPIRE_PROMOTE 0
+#define A3D_WORKQ_EXPIRE_PURGE   1
+
 /* called from the workq thread */
 typedef int  (*a3d_workqrun_fn)(int tid,
                                 void* owner,
@@ -42,49 +48,281 @@ typedef void (*a3d_workqpurge_fn)(void* owner,
                                   void* task,
                                   int status);
 
-typedef struct
+// work stealing workers reserve up to
+// A3D_WORKQ_DEQUE_SIZE pending tasks at a time
+#define A3D_WORKQ_DEQUE_SIZE 16
+
+typedef struct a3d_workqnode_s
 {
 	int   status;
 	int   priority;
-	int   purge_id;
+	int   queue;
 	void* task;
+
+	// epoch when the task was last run (0 to purge)
+	uint64_t epoch;
+
+	// pending heap position and FIFO order
+	int      heap_idx;
+	uint64_t seq;
+
+	// aged priority rank and deadline (0 for none)
+	int64_t  rank;
+	uint64_t deadline;
+	int      expired;
+
+	// work stealing deque owner and completion link
+	int                     tid;
+	struct a3d_workqnode_s* next;
+
+	// cooperative cancel flag polled by run_fn
+	int cancel;
+
+	// dependency graph (NULL until used)
+	// prereqs are the incomplete tasks which must complete
+	// before the node is pending and dependents are the
+	// blocked nodes which wait for the node
+	a3d_array_t* prereqs;
+	a3d_array_t* dependents;
+
+	// monotonic timestamps for stats
+	uint64_t t_enqueue;
+	uint64_t t_complete;
+
+	// queue link
+	a3d_listitem_t item;
 } a3d_workqnode_t;
 
+// log-linear histogram with 8 buckets per power of two
+// which bounds the percentile error to 12.5%
+#define A3D_WORKQ_HIST_BUCKETS 496
+
+typedef struct
+{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t bucket[A3D_WORKQ_HIST_BUCKETS];
+} a3d_workqhist_t;
+
+// per thread counters are only written by the worker
+typedef struct
+{
+	a3d_workqhist_t wait;
+	a3d_workqhist_t run;
+	uint64_t        busy;
+} a3d_workqcounters_t;
+
+typedef struct
+{
+	uint64_t count;
+	double   mean;
+	double   p50;
+	double   p95;
+	double   p99;
+	double   max;
+} a3d_workqdist_t;
+
+typedef struct
+{
+	// current queue depth and running threads
+	int pending;
+	int reserved;
+	int active;
+	int complete;
+	int blocked;
+	int threads;
+
+	// tasks which passed their deadline while pending
+	uint64_t expired;
+
+	// distributions since the last a3d_workq_statsReset
+	// depth is sampled from the pending queue on submit
+	// wait:    enqueue to start (seconds)
+	// run:     run_fn duration (seconds)
+	// collect: complete to collect (seconds)
+	a3d_workqdist_t depth;
+	a3d_workqdist_t wait;
+	a3d_workqdist_t run;
+	a3d_workqdist_t collect;
+
+	// elapsed seconds and completed tasks per second
+	double elapsed;
+	double throughput;
+} a3d_workqstats_t;
+
 typedef struct
+{
+	pthread_mutex_t  mutex;
+	int              head;
+	int              count;
+	a3d_workqnode_t* nodes[A3D_WORKQ_DEQUE_SIZE];
+} a3d_workqdeque_t;
+
+struct a3d_workq_s;
+
+// shared pool of threads which runs the tasks of the attached
+// workqs in order of the workq priority and then in
+// proportion to the workq weight
+typedef struct a3d_workqpool_s
+{
+	int             state;
+	int             thread_count;
+	pthread_t*      threads;
+	int             next_tid;
+	a3d_list_t*     queues;
+	uint64_t        vtime;
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond_pending;
+	pthread_cond_t  cond_detach;
+} a3d_workqpool_t;
+
+typedef struct
+{
+	struct a3d_workq_s* workq;
+	pthread_t           thread;
+	int                 tid;
+	int                 state;
+} a3d_workqthread_t;
+
+typedef struct a3d_workq_s
 {
 	// queue state
-	int   state;
-	void* owner;
-	int   purge_id;
+	// the epoch is advanced by each purge
+	int      state;
+	void*    owner;
+	uint64_t epoch;
+	uint64_t seq;
 
 	// queues
-	a3d_list_t* queue_pending;
-	a3d_list_t* queue_complete;
-	a3d_list_t* queue_active;
+	// queue_pending is a binary heap of nodes ordered by
+	// expired deadline, rank and then by seq
+	a3d_array_t* queue_pending;
+	a3d_list_t*  queue_complete;
+	a3d_list_t*  queue_active;
+
+	// nodes waiting for their prerequisites
+	// blocked_count is read by the work stealing workers
+	a3d_list_t* queue_blocked;
+	int         blocked_count;
+
+	// task index
+	a3d_intmap_t* index;
+
+	// work stealing
+	// workers reserve pending nodes in their deques and push
+	// finished nodes to the lock-free completed list which
+	// is collected into queue_complete by the main thread
+	int               stealing;
+	a3d_workqdeque_t* deques;
+	int               reserved_count;
+	int               active_count;
+	int               waiters;
+	a3d_workqnode_t*  completed;
+
+	// stats
+	// collect and depth are protected by the mutex while
+	// the thread counters are compared with a baseline
+	// since the workers cannot be reset
+	uint64_t             stats_t0;
+	a3d_workqhist_t      stats_depth;
+	a3d_workqhist_t      stats_collect;
+	uint64_t             stats_expired;
+	a3d_workqcounters_t* stats_thread;
+	a3d_workqcounters_t* stats_base;
 
 	// callbacks
 	a3d_workqrun_fn   run_fn;
 	a3d_workqpurge_fn purge_fn;
 
 	// workq thread(s)
-	int             thread_count;
-	pthread_t*      threads;
-	int             next_tid;
-	pthread_mutex_t mutex;
-	pthread_cond_t  cond_pending;
-	pthread_cond_t  cond_complete;
+	// thread_count is the maximum number of threads and the
+	// tid passed to run_fn is the index of the thread slot
+	int                thread_count;
+	a3d_workqthread_t* threads;
+	a3d_workqnode_t**  running;
+	pthread_mutex_t    mutex;
+	pthread_cond_t     cond_pending;
+	pthread_cond_t     cond_complete;
+
+	// dynamic threads
+	// threads are added when the pending backlog per thread
+	// or the wait for the next task exceeds the threshold
+	// and threads above thread_min retire when idle
+	int      thread_min;
+	int      thread_live;
+	int      thread_idle;
+	int      scale_backlog;
+	uint64_t scale_latency;
+	uint64_t scale_timeout;
+
+	// aging and deadlines
+	// the rank of a pending node rises by one priority per
+	// aging interval of wait (0 disables aging) and
+	// deadline_next is the earliest deadline which may be
+	// pending (0 for none)
+	uint64_t aging;
+	int      expire;
+	uint64_t deadline_next;
+
+	// shared pool
+	// pool_pending, pool_busy and pool_vtime are protected by
+	// the pool mutex and pool_synced by the workq mutex
+	a3d_workqpool_t* pool;
+	int              pool_priority;
+	int              pool_weight;
+	int              pool_pending;
+	int              pool_synced;
+	int              pool_busy;
+	uint64_t         pool_vtime;
 } a3d_workq_t;
 
+a3d_workqpool_t* a3d_workqpool_new(int thread_count);
+void             a3d_workqpool_delete(a3d_workqpool_t** _self);
+
 a3d_workq_t* a3d_workq_new(void* owner, int thread_count,
                            a3d_workqrun_fn run_fn,
                            a3d_workqpurge_fn purge_fn);
+a3d_workq_t* a3d_workq_newStealing(void* owner, int thread_count,
+                                   a3d_workqrun_fn run_fn,
+                                   a3d_workqpurge_fn purge_fn);
+a3d_workq_t* a3d_workq_newShared(void* owner,
+                                 a3d_workqpool_t* pool,
+                                 int priority, int weight,
+                                 a3d_workqrun_fn run_fn,
+                                 a3d_workqpurge_fn purge_fn);
+a3d_workq_t* a3d_workq_newDynamic(void* owner, int min_threads,
+                                  int max_threads,
+                                  a3d_workqrun_fn run_fn,
+                                  a3d_workqpurge_fn purge_fn);
 void         a3d_workq_delete(a3d_workq_t** _self);
+void         a3d_workq_scaling(a3d_workq_t* self, int backlog,
+                               double latency, double timeout);
+void         a3d_workq_aging(a3d_workq_t* self, double interval);
+void         a3d_workq_expire(a3d_workq_t* self, int expire);
 void         a3d_workq_reset(a3d_workq_t* self, int blocking);
 void         a3d_workq_purge(a3d_workq_t* self);
+void         a3d_workq_purgeOlderThan(a3d_workq_t* self,
+                                      int epochs);
 int          a3d_workq_run(a3d_workq_t* self, void* task,
                            int priority);
+int          a3d_workq_runAfter(a3d_workq_t* self, void* task,
+                                int priority, void** deps,
+                                int count);
+int          a3d_workq_runDeadline(a3d_workq_t* self, void* task,
+                                   int priority, double deadline);
+void         a3d_workq_runBatch(a3d_workq_t* self, void** tasks,
+                                const int* priorities, int count,
+                                int* status);
+int          a3d_workq_drain(a3d_workq_t* self, void** tasks,
+                             int* status, int count);
 int          a3d_workq_cancel(a3d_workq_t* self, void* task);
+int          a3d_workq_cancelAsync(a3d_workq_t* self, void* task);
+int          a3d_workq_cancelled(a3d_workq_t* self, int tid);
 int          a3d_workq_status(a3d_workq_t* self, void* task);
 int          a3d_workq_pending(a3d_workq_t* self);
+void         a3d_workq_stats(a3d_workq_t* self,
+                             a3d_workqstats_t* stats,
+                             double* utilization);
+void         a3d_workq_statsReset(a3d_workq_t* self);
 
 #endif
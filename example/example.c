@@ -23,6 +23,9 @@
 
 #include <stdlib.h>
 #include "test_list.h"
+#include "test_array.h"
+#include "test_intmap.h"
+#include "test_sharedmap.h"
 #include "test_workq.h"
 #include "test_cache.h"
 #include "test_orientation.h"
@@ -34,6 +37,9 @@
 int main(int argc, char** argv)
 {
 	test_list();
+	test_array();
+	test_intmap();
+	test_sharedmap();
 	test_workq();
 	test_cache();
 	test_orientation();
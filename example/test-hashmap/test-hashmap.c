@@ -22,14 +22,276 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include "a3d/a3d_hashmap.h"
+#include "a3d/a3d_timestamp.h"
 
 #define LOG_TAG "test-hashmap"
 #include "a3d/a3d_log.h"
 
+#define BENCH_ROUNDS  10
+#define BENCH_KEY_LEN 64
+
+typedef void (*bench_key_fn)(char* key, int i);
+
+static void tile_key(char* key, int i)
+{
+	// zoom/x/y for a 64x64 block of tiles per zoom level
+	int zoom = 8 + i/4096;
+	int x    = 1000 + (i%4096)/64;
+	int y    = 2000 + i%64;
+	snprintf(key, BENCH_KEY_LEN, "%i/%i/%i", zoom, x, y);
+}
+
+static void resource_key(char* key, int i)
+{
+	const char* dir[] =
+	{
+		"textures/terrain",
+		"textures/water",
+		"shaders/gl2",
+		"models/buildings",
+	};
+	snprintf(key, BENCH_KEY_LEN, "%s/resource%04i.pak",
+	         dir[i%4], i/4);
+}
+
+static void font_key(char* key, int i)
+{
+	const char* style[] =
+	{
+		"Regular",
+		"Bold",
+		"Italic",
+		"BoldItalic",
+	};
+	snprintf(key, BENCH_KEY_LEN, "BarlowSemiCondensed-%s-%i-%i",
+	         style[i%4], 8 + (i/4)%64, i/256);
+}
+
+static void bench_prefix(const char* name,
+                         a3d_hashmap_t* hashmap,
+                         const char* prefix)
+{
+	// compare a prefix query with a full scan
+	a3d_hashmapIter_t  iterator;
+	a3d_hashmapIter_t* iter;
+	int    len = strlen(prefix);
+	int    j;
+	int    scan_found   = 0;
+	int    prefix_found = 0;
+	double t0 = a3d_timestamp();
+	for(j = 0; j < BENCH_ROUNDS; ++j)
+	{
+		iter = a3d_hashmap_head(hashmap, &iterator);
+		while(iter)
+		{
+			if(strncmp(a3d_hashmap_key(iter), prefix, len) == 0)
+			{
+				++scan_found;
+			}
+			iter = a3d_hashmap_next(iter);
+		}
+	}
+
+	double t1 = a3d_timestamp();
+	for(j = 0; j < BENCH_ROUNDS; ++j)
+	{
+		iter = a3d_hashmap_findPrefix(hashmap, &iterator, prefix);
+		while(iter)
+		{
+			++prefix_found;
+			iter = a3d_hashmap_next(iter);
+		}
+	}
+
+	double t2 = a3d_timestamp();
+
+	LOGI("%s prefix=%s: found=%i/%i, scan=%lf, prefix=%lf",
+	     name, prefix, prefix_found, scan_found,
+	     t1 - t0, t2 - t1);
+}
+
+static void bench_handle(int count, int ordered)
+{
+	// compare findf with the key handles that a tile
+	// cache would keep across frames
+	a3d_hashmap_t* hashmap;
+	if(ordered)
+	{
+		hashmap = a3d_hashmap_newOrdered();
+	}
+	else
+	{
+		hashmap = a3d_hashmap_new();
+	}
+
+	if(hashmap == NULL)
+	{
+		return;
+	}
+
+	a3d_hashmapKey_t* keys = (a3d_hashmapKey_t*)
+	                         malloc(count*sizeof(a3d_hashmapKey_t));
+	if(keys == NULL)
+	{
+		a3d_hashmap_delete(&hashmap);
+		return;
+	}
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		a3d_hashmapKey_initf(&keys[i], "%i/%i/%i",
+		                     10, i/64, i%64);
+		a3d_hashmap_addKey(hashmap, (const void*) hashmap,
+		                   &keys[i]);
+	}
+
+	a3d_hashmapIter_t iter;
+	int    j;
+	int    findf_found = 0;
+	int    key_found   = 0;
+	double t0 = a3d_timestamp();
+	for(j = 0; j < BENCH_ROUNDS; ++j)
+	{
+		for(i = 0; i < count; ++i)
+		{
+			if(a3d_hashmap_findf(hashmap, &iter, "%i/%i/%i",
+			                     10, i/64, i%64))
+			{
+				++findf_found;
+			}
+		}
+	}
+
+	double t1 = a3d_timestamp();
+	for(j = 0; j < BENCH_ROUNDS; ++j)
+	{
+		for(i = 0; i < count; ++i)
+		{
+			if(a3d_hashmap_findKey(hashmap, &iter, &keys[i]))
+			{
+				++key_found;
+			}
+		}
+	}
+
+	double t2 = a3d_timestamp();
+
+	LOGI("handle %s: found=%i/%i, findf=%lf, findKey=%lf",
+	     ordered ? "trie" : "hash", key_found, findf_found,
+	     t1 - t0, t2 - t1);
+
+	free(keys);
+	a3d_hashmap_discard(hashmap);
+	a3d_hashmap_delete(&hashmap);
+}
+
+static void bench_teardown(int count)
+{
+	// build and destroy a large ordered hashmap
+	a3d_hashmap_t* hashmap = a3d_hashmap_newOrdered();
+	if(hashmap == NULL)
+	{
+		return;
+	}
+
+	char   key[BENCH_KEY_LEN];
+	int    i;
+	double t0 = a3d_timestamp();
+	for(i = 0; i < count; ++i)
+	{
+		tile_key(key, i);
+		a3d_hashmap_add(hashmap, (const void*) hashmap, key);
+	}
+
+	double t1    = a3d_timestamp();
+	int    nodes = a3d_hashmap_hashmapNodes(hashmap);
+	a3d_hashmap_discard(hashmap);
+	a3d_hashmap_delete(&hashmap);
+	double t2 = a3d_timestamp();
+
+	LOGI("teardown: count=%i, nodes=%i, add=%lf, delete=%lf",
+	     count, nodes, t1 - t0, t2 - t1);
+}
+
+static void bench(const char* name, bench_key_fn key_fn,
+                  int count, int ordered, const char* prefix)
+{
+	a3d_hashmap_t* hashmap;
+	if(ordered)
+	{
+		hashmap = a3d_hashmap_newOrdered();
+	}
+	else
+	{
+		hashmap = a3d_hashmap_new();
+	}
+
+	if(hashmap == NULL)
+	{
+		return;
+	}
+
+	// generate keys up front to exclude snprintf
+	char* keys = (char*) malloc(count*BENCH_KEY_LEN);
+	if(keys == NULL)
+	{
+		a3d_hashmap_delete(&hashmap);
+		return;
+	}
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		key_fn(&keys[i*BENCH_KEY_LEN], i);
+	}
+
+	a3d_hashmapIter_t iter;
+	double t0 = a3d_timestamp();
+	for(i = 0; i < count; ++i)
+	{
+		a3d_hashmap_add(hashmap, (const void*) hashmap,
+		                &keys[i*BENCH_KEY_LEN]);
+	}
+
+	double t1 = a3d_timestamp();
+
+	int j;
+	int found = 0;
+	for(j = 0; j < BENCH_ROUNDS; ++j)
+	{
+		for(i = 0; i < count; ++i)
+		{
+			if(a3d_hashmap_find(hashmap, &iter,
+			                    &keys[i*BENCH_KEY_LEN]))
+			{
+				++found;
+			}
+		}
+	}
+
+	double t2 = a3d_timestamp();
+
+	LOGI("%s %s: count=%i, found=%i, add=%lf, find=%lf, bytes=%i",
+	     name, ordered ? "trie" : "hash", count, found,
+	     t1 - t0, t2 - t1, a3d_hashmap_hashmapSize(hashmap));
+
+	if(ordered)
+	{
+		bench_prefix(name, hashmap, prefix);
+	}
+
+	free(keys);
+	a3d_hashmap_discard(hashmap);
+	a3d_hashmap_delete(&hashmap);
+}
+
 int main(int argc, char** argv)
 {
-	a3d_hashmap_t* hashmap = a3d_hashmap_new();
+	a3d_hashmap_t* hashmap = a3d_hashmap_newOrdered();
 	if(hashmap == NULL)
 	{
 		return EXIT_FAILURE;
@@ -51,29 +313,24 @@ int main(int argc, char** argv)
 	a3d_hashmapIter_t* iter = &iterator;
 	const int*  val;
 	const char* key;
-	if(a3d_hashmap_add(hashmap,  iter, (const void*) &zero,  "zero"))
-	{
-		val = (const int*) a3d_hashmap_val(iter);
-		key = a3d_hashmap_key(iter);
-		LOGI("iter: key=%s, val=%i", key, *val);
-	}
-
-	a3d_hashmap_add(hashmap,  iter, (const void*) &one,   "one");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &two,   "two");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &three, "three");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &four,  "four");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &five,  "five");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &six,   "six");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &seven, "seven");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &eight, "eight");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &nine,  "nine");
-	a3d_hashmap_addf(hashmap, iter, (const void*) &ten,   "%i", 10);
-	a3d_hashmap_add(hashmap,  iter, (const void*) &one,   "fib");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &two,   "fib");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &one,   "fib");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &three, "fib");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &eight, "fib");
-	a3d_hashmap_add(hashmap,  iter, (const void*) &five,  "fib");
+	a3d_hashmap_add(hashmap,  (const void*) &zero,  "zero");
+
+	a3d_hashmap_add(hashmap,  (const void*) &one,   "one");
+	a3d_hashmap_add(hashmap,  (const void*) &two,   "two");
+	a3d_hashmap_add(hashmap,  (const void*) &three, "three");
+	a3d_hashmap_add(hashmap,  (const void*) &four,  "four");
+	a3d_hashmap_add(hashmap,  (const void*) &five,  "five");
+	a3d_hashmap_add(hashmap,  (const void*) &six,   "six");
+	a3d_hashmap_add(hashmap,  (const void*) &seven, "seven");
+	a3d_hashmap_add(hashmap,  (const void*) &eight, "eight");
+	a3d_hashmap_add(hashmap,  (const void*) &nine,  "nine");
+	a3d_hashmap_addf(hashmap, (const void*) &ten,   "%i", 10);
+	a3d_hashmap_add(hashmap,  (const void*) &one,   "fib");
+	a3d_hashmap_add(hashmap,  (const void*) &two,   "fib");
+	a3d_hashmap_add(hashmap,  (const void*) &one,   "fib");
+	a3d_hashmap_add(hashmap,  (const void*) &three, "fib");
+	a3d_hashmap_add(hashmap,  (const void*) &eight, "fib");
+	a3d_hashmap_add(hashmap,  (const void*) &five,  "fib");
 
 	LOGI("size=%i", a3d_hashmap_size(hashmap));
 
@@ -111,8 +368,42 @@ int main(int argc, char** argv)
 		LOGI("key=%s, val=%i", key, *val);
 	}
 
+	LOGI("%s", "PREFIX");
+	iter = a3d_hashmap_findPrefix(hashmap, &iterator, "f");
+	while(iter)
+	{
+		val = (const int*) a3d_hashmap_val(iter);
+		key = a3d_hashmap_key(iter);
+		LOGI("key=%s, val=%i", key, *val);
+		iter = a3d_hashmap_next(iter);
+	}
+
+	LOGI("%s", "RANGE");
+	iter = a3d_hashmap_range(hashmap, &iterator, "nine", "six");
+	while(iter)
+	{
+		val = (const int*) a3d_hashmap_val(iter);
+		key = a3d_hashmap_key(iter);
+		LOGI("key=%s, val=%i", key, *val);
+		iter = a3d_hashmap_next(iter);
+	}
+
 	a3d_hashmap_discard(hashmap);
 	a3d_hashmap_delete(&hashmap);
 
+	LOGI("%s", "BENCH");
+	int ordered;
+	for(ordered = 0; ordered <= 1; ++ordered)
+	{
+		bench("tile",     tile_key,     65536, ordered,
+		      "9/1010/");
+		bench("resource", resource_key, 4096,  ordered,
+		      "textures/water/");
+		bench("font",     font_key,     1024,  ordered,
+		      "BarlowSemiCondensed-Bold-");
+		bench_handle(4096, ordered);
+	}
+	bench_teardown(1000000);
+
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "a3d/a3d_intmap.h"
+#include "a3d/a3d_hashmap.h"
+#include "a3d/a3d_timestamp.h"
+
+#define LOG_TAG "test-intmap"
+#include "a3d/a3d_log.h"
+
+#define TEST_KEYS 1000000
+
+// tiles are in a 1024x1024 block at zoom 15 where the
+// string path formats the same coordinates as "%i/%i/%i"
+#define TEST_ZOOM 15
+#define TEST_X(i) (8000 + (i)/1024)
+#define TEST_Y(i) (4000 + (i)%1024)
+
+static uint64_t tile_key(int zoom, int x, int y)
+{
+	return (((uint64_t) zoom) << 48) |
+	       (((uint64_t) x)    << 24) |
+	       ((uint64_t) y);
+}
+
+static void bench_intmap(void)
+{
+	a3d_intmap_t* intmap = a3d_intmap_new();
+	if(intmap == NULL)
+	{
+		return;
+	}
+
+	int    i;
+	double t0 = a3d_timestamp();
+	for(i = 0; i < TEST_KEYS; ++i)
+	{
+		a3d_intmap_add(intmap, (const void*) intmap,
+		               tile_key(TEST_ZOOM, TEST_X(i), TEST_Y(i)));
+	}
+
+	double t1    = a3d_timestamp();
+	int    found = 0;
+	a3d_intmapIter_t iter;
+	for(i = 0; i < TEST_KEYS; ++i)
+	{
+		if(a3d_intmap_find(intmap, &iter,
+		                   tile_key(TEST_ZOOM, TEST_X(i),
+		                            TEST_Y(i))))
+		{
+			++found;
+		}
+	}
+
+	double t2 = a3d_timestamp();
+
+	LOGI("intmap: found=%i, add=%lf, find=%lf, bytes=%i",
+	     found, t1 - t0, t2 - t1, a3d_intmap_intmapSize(intmap));
+
+	a3d_intmap_discard(intmap);
+	a3d_intmap_delete(&intmap);
+}
+
+static void bench_hashmap(int ordered)
+{
+	a3d_hashmap_t* hashmap;
+	if(ordered)
+	{
+		hashmap = a3d_hashmap_newOrdered();
+	}
+	else
+	{
+		hashmap = a3d_hashmap_new();
+	}
+
+	if(hashmap == NULL)
+	{
+		return;
+	}
+
+	int    i;
+	double t0 = a3d_timestamp();
+	for(i = 0; i < TEST_KEYS; ++i)
+	{
+		a3d_hashmap_addf(hashmap, (const void*) hashmap,
+		                 "%i/%i/%i", TEST_ZOOM, TEST_X(i),
+		                 TEST_Y(i));
+	}
+
+	double t1    = a3d_timestamp();
+	int    found = 0;
+	a3d_hashmapIter_t iter;
+	for(i = 0; i < TEST_KEYS; ++i)
+	{
+		if(a3d_hashmap_findf(hashmap, &iter, "%i/%i/%i",
+		                     TEST_ZOOM, TEST_X(i), TEST_Y(i)))
+		{
+			++found;
+		}
+	}
+
+	double t2 = a3d_timestamp();
+
+	LOGI("hashmap %s: found=%i, add=%lf, find=%lf, bytes=%i",
+	     ordered ? "trie" : "hash", found, t1 - t0, t2 - t1,
+	     a3d_hashmap_hashmapSize(hashmap));
+
+	a3d_hashmap_discard(hashmap);
+	a3d_hashmap_delete(&hashmap);
+}
+
+int main(int argc, char** argv)
+{
+	bench_intmap();
+	bench_hashmap(0);
+	bench_hashmap(1);
+
+	return EXIT_SUCCESS;
+}
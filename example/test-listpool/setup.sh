@@ -0,0 +1 @@
+ln -s ../../../a3d
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "a3d/a3d_list.h"
+#include "a3d/a3d_timestamp.h"
+
+#define LOG_TAG "test-listpool"
+#include "a3d/a3d_log.h"
+
+#define TEST_ITEMS  100000
+#define TEST_ROUNDS 100
+
+static long rss_kb(void)
+{
+	// resident set size from /proc/self/statm
+	long size     = 0;
+	long resident = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if(f == NULL)
+	{
+		return 0;
+	}
+
+	if(fscanf(f, "%li %li", &size, &resident) != 2)
+	{
+		resident = 0;
+	}
+	fclose(f);
+
+	return resident*(sysconf(_SC_PAGESIZE)/1024);
+}
+
+static void bench(const char* name, a3d_list_t* list)
+{
+	long   rss0 = rss_kb();
+	double t0   = a3d_timestamp();
+
+	// churn items by filling and draining the list
+	int   i;
+	int   j;
+	long  rss1 = rss0;
+	for(j = 0; j < TEST_ROUNDS; ++j)
+	{
+		for(i = 1; i <= TEST_ITEMS; ++i)
+		{
+			a3d_list_push(list, (const void*) (long) i);
+		}
+
+		if(j == 0)
+		{
+			rss1 = rss_kb();
+		}
+
+		while(a3d_list_pop(list))
+		{
+			// empty
+		}
+	}
+
+	double t1  = a3d_timestamp();
+	double ops = 2.0*TEST_ITEMS*TEST_ROUNDS/(t1 - t0);
+	LOGI("%s: dt=%lf, ops/s=%.0lf, rss=%li KB",
+	     name, t1 - t0, ops, rss1 - rss0);
+}
+
+int main(int argc, char** argv)
+{
+	// run "test-listpool pool" or "test-listpool malloc"
+	// separately for an accurate rss comparison since
+	// the second run may reuse pages freed by the first
+	int run_pool   = 1;
+	int run_malloc = 1;
+	if(argc == 2)
+	{
+		run_pool   = (strcmp(argv[1], "pool")   == 0);
+		run_malloc = (strcmp(argv[1], "malloc") == 0);
+	}
+
+	if(run_pool)
+	{
+		a3d_list_t* list = a3d_list_newPool(NULL);
+		if(list == NULL)
+		{
+			return EXIT_FAILURE;
+		}
+
+		bench("pool", list);
+		a3d_list_delete(&list);
+	}
+
+	if(run_malloc)
+	{
+		a3d_list_t* list = a3d_list_new();
+		if(list == NULL)
+		{
+			return EXIT_FAILURE;
+		}
+
+		bench("malloc", list);
+		a3d_list_delete(&list);
+	}
+
+	return EXIT_SUCCESS;
+}
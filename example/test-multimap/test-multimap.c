@@ -66,27 +66,26 @@ int main(int argc, char** argv)
 	int ten    = 10;
 	a3d_multimapIter_t  iterator;
 	a3d_multimapIter_t* iter = &iterator;
-	a3d_multimap_add(multimap,  iter, (const void*) &zero,  "zero");
-	a3d_multimap_add(multimap,  iter, (const void*) &one,   "one");
-	a3d_multimap_add(multimap,  iter, (const void*) &two,   "two");
-	a3d_multimap_add(multimap,  iter, (const void*) &three, "three");
-	a3d_multimap_add(multimap,  iter, (const void*) &four,  "four");
-	a3d_multimap_add(multimap,  iter, (const void*) &five,  "five");
-	a3d_multimap_add(multimap,  iter, (const void*) &six,   "six");
-	a3d_multimap_add(multimap,  iter, (const void*) &seven, "seven");
-	a3d_multimap_add(multimap,  iter, (const void*) &eight, "eight");
-	a3d_multimap_add(multimap,  iter, (const void*) &nine,  "nine");
-	a3d_multimap_addf(multimap, iter, (const void*) &ten,   "%i", 10);
-	a3d_multimap_add(multimap,  iter, (const void*) &one,   "fib");
-	a3d_multimap_add(multimap,  iter, (const void*) &two,   "fib");
-	a3d_multimap_add(multimap,  iter, (const void*) &one,   "fib");
-	a3d_multimap_add(multimap,  iter, (const void*) &three, "fib");
-	a3d_multimap_add(multimap,  iter, (const void*) &eight, "fib");
-	a3d_multimap_add(multimap,  iter, (const void*) &five,  "fib");
+	a3d_multimap_add(multimap,  (const void*) &zero,  "zero");
+	a3d_multimap_add(multimap,  (const void*) &one,   "one");
+	a3d_multimap_add(multimap,  (const void*) &two,   "two");
+	a3d_multimap_add(multimap,  (const void*) &three, "three");
+	a3d_multimap_add(multimap,  (const void*) &four,  "four");
+	a3d_multimap_add(multimap,  (const void*) &five,  "five");
+	a3d_multimap_add(multimap,  (const void*) &six,   "six");
+	a3d_multimap_add(multimap,  (const void*) &seven, "seven");
+	a3d_multimap_add(multimap,  (const void*) &eight, "eight");
+	a3d_multimap_add(multimap,  (const void*) &nine,  "nine");
+	a3d_multimap_addf(multimap, (const void*) &ten,   "%i", 10);
+	a3d_multimap_add(multimap,  (const void*) &one,   "fib");
+	a3d_multimap_add(multimap,  (const void*) &two,   "fib");
+	a3d_multimap_add(multimap,  (const void*) &one,   "fib");
+	a3d_multimap_add(multimap,  (const void*) &three, "fib");
+	a3d_multimap_add(multimap,  (const void*) &eight, "fib");
+	a3d_multimap_add(multimap,  (const void*) &five,  "fib");
 
-	const int*  val = (const int*) a3d_multimap_val(iter);
-	const char* key = a3d_multimap_key(iter);
-	LOGI("iter: key=%s, val=%i", key, *val);
+	const int*  val;
+	const char* key;
 
 	LOGI("size=%i", a3d_multimap_size(multimap));
 
@@ -113,6 +112,24 @@ int main(int argc, char** argv)
 		}
 	}
 
+	LOGI("%s", "COPY");
+	iter = &iterator;
+	if(a3d_multimap_find(multimap, iter, "fib"))
+	{
+		// iterators may be copied by value
+		a3d_multimapIter_t  copy  = iterator;
+		a3d_multimapIter_t* citer = &copy;
+		citer = a3d_multimap_nextItem(citer);
+		if(citer)
+		{
+			LOGI("sizeof=%i, key=%s, val=%i, next=%i",
+			     (int) sizeof(copy),
+			     a3d_multimap_key(citer),
+			     *((const int*) a3d_multimap_val(iter)),
+			     *((const int*) a3d_multimap_val(citer)));
+		}
+	}
+
 	iter = a3d_multimap_head(multimap, &iterator);
 	if(iter)
 	{
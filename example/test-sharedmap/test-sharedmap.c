@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "a3d/a3d_sharedmap.h"
+#include "a3d/a3d_hashmap.h"
+#include "a3d/a3d_timestamp.h"
+
+#define LOG_TAG "test-sharedmap"
+#include "a3d/a3d_log.h"
+
+#define TEST_KEYS    4096
+#define TEST_FINDS   1000000
+#define TEST_THREADS 8
+
+typedef struct
+{
+	int tid;
+	int found;
+
+	// maps
+	a3d_sharedmap_t* sharedmap;
+	a3d_hashmap_t*   hashmap;
+	pthread_mutex_t* mutex;
+} reader_t;
+
+static int vals[TEST_KEYS];
+
+static int writer_done;
+
+static void* reader_shared(void* arg)
+{
+	reader_t* r = (reader_t*) arg;
+
+	// bracket small batches of finds like a run_fn
+	int i;
+	int j;
+	char key[256];
+	for(i = 0; i < TEST_FINDS; i += 64)
+	{
+		a3d_sharedmap_readLock(r->sharedmap, r->tid);
+		for(j = i; j < i + 64; ++j)
+		{
+			snprintf(key, 256, "tile-%i", (j*7 + r->tid)%TEST_KEYS);
+			const int* val;
+			val = (const int*) a3d_sharedmap_find(r->sharedmap, key);
+			if(val && (*val >= 0))
+			{
+				++r->found;
+			}
+		}
+		a3d_sharedmap_readUnlock(r->sharedmap, r->tid);
+	}
+
+	return NULL;
+}
+
+static void* reader_mutex(void* arg)
+{
+	reader_t* r = (reader_t*) arg;
+
+	int i;
+	int j;
+	char key[256];
+	a3d_hashmapIter_t iter;
+	for(i = 0; i < TEST_FINDS; i += 64)
+	{
+		pthread_mutex_lock(r->mutex);
+		for(j = i; j < i + 64; ++j)
+		{
+			snprintf(key, 256, "tile-%i", (j*7 + r->tid)%TEST_KEYS);
+			const int* val;
+			val = (const int*) a3d_hashmap_find(r->hashmap, &iter, key);
+			if(val && (*val >= 0))
+			{
+				++r->found;
+			}
+		}
+		pthread_mutex_unlock(r->mutex);
+	}
+
+	return NULL;
+}
+
+static void* writer_shared(void* arg)
+{
+	a3d_sharedmap_t* sharedmap = (a3d_sharedmap_t*) arg;
+
+	// churn keys which the readers do not find
+	int i = 0;
+	char key[256];
+	while(__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE) == 0)
+	{
+		snprintf(key, 256, "churn-%i", i%256);
+		if(a3d_sharedmap_add(sharedmap, &vals[0], key) == 0)
+		{
+			a3d_sharedmap_remove(sharedmap, key);
+		}
+		++i;
+	}
+
+	return NULL;
+}
+
+static void* writer_mutex(void* arg)
+{
+	reader_t* r = (reader_t*) arg;
+
+	int i = 0;
+	char key[256];
+	while(__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE) == 0)
+	{
+		a3d_hashmapIter_t iter;
+		snprintf(key, 256, "churn-%i", i%256);
+		pthread_mutex_lock(r->mutex);
+		if(a3d_hashmap_find(r->hashmap, &iter, key))
+		{
+			a3d_hashmapIter_t* iterp = &iter;
+			a3d_hashmap_remove(r->hashmap, &iterp);
+		}
+		else
+		{
+			a3d_hashmap_add(r->hashmap, &vals[0], key);
+		}
+		pthread_mutex_unlock(r->mutex);
+		++i;
+	}
+
+	return NULL;
+}
+
+static void bench(const char* name, int threads, int shared,
+                  int write, a3d_sharedmap_t* sharedmap,
+                  a3d_hashmap_t* hashmap, pthread_mutex_t* mutex)
+{
+	pthread_t thread[TEST_THREADS];
+	pthread_t writer;
+	reader_t  reader[TEST_THREADS];
+	reader_t  wr =
+	{
+		.tid       = 0,
+		.found     = 0,
+		.sharedmap = sharedmap,
+		.hashmap   = hashmap,
+		.mutex     = mutex
+	};
+
+	__atomic_store_n(&writer_done, 0, __ATOMIC_RELEASE);
+	if(write)
+	{
+		if(shared)
+		{
+			pthread_create(&writer, NULL, writer_shared,
+			               (void*) sharedmap);
+		}
+		else
+		{
+			pthread_create(&writer, NULL, writer_mutex,
+			               (void*) &wr);
+		}
+	}
+
+	double t0 = a3d_timestamp();
+
+	int i;
+	for(i = 0; i < threads; ++i)
+	{
+		reader[i] = wr;
+		reader[i].tid = i;
+		pthread_create(&thread[i], NULL,
+		               shared ? reader_shared : reader_mutex,
+		               (void*) &reader[i]);
+	}
+
+	int found = 0;
+	for(i = 0; i < threads; ++i)
+	{
+		pthread_join(thread[i], NULL);
+		found += reader[i].found;
+	}
+
+	double t1 = a3d_timestamp();
+
+	if(write)
+	{
+		__atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+		pthread_join(writer, NULL);
+	}
+
+	double ops = ((double) threads)*TEST_FINDS/(t1 - t0);
+	LOGI("%s: threads=%i, writer=%i, dt=%lf, finds/s=%.0lf, found=%i",
+	     name, threads, write, t1 - t0, ops, found);
+}
+
+int main(int argc, char** argv)
+{
+	a3d_sharedmap_t* sharedmap = a3d_sharedmap_new(TEST_THREADS);
+	if(sharedmap == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	a3d_hashmap_t* hashmap = a3d_hashmap_new();
+	if(hashmap == NULL)
+	{
+		goto fail_hashmap;
+	}
+
+	pthread_mutex_t mutex;
+	if(pthread_mutex_init(&mutex, NULL) != 0)
+	{
+		goto fail_mutex;
+	}
+
+	int i;
+	for(i = 0; i < TEST_KEYS; ++i)
+	{
+		vals[i] = i;
+		if((a3d_sharedmap_addf(sharedmap, &vals[i],
+		                       "tile-%i", i) == 0) ||
+		   (a3d_hashmap_addf(hashmap, &vals[i],
+		                     "tile-%i", i) == 0))
+		{
+			goto fail_add;
+		}
+	}
+
+	int threads;
+	int write;
+	for(write = 0; write <= 1; ++write)
+	{
+		for(threads = 1; threads <= TEST_THREADS; threads *= 2)
+		{
+			bench("mutex", threads, 0, write,
+			      sharedmap, hashmap, &mutex);
+			bench("shared", threads, 1, write,
+			      sharedmap, hashmap, &mutex);
+		}
+	}
+
+	pthread_mutex_destroy(&mutex);
+	a3d_hashmap_discard(hashmap);
+	a3d_hashmap_delete(&hashmap);
+	a3d_sharedmap_discard(sharedmap);
+	a3d_sharedmap_delete(&sharedmap);
+
+	// success
+	return EXIT_SUCCESS;
+
+	// failure
+	fail_add:
+		pthread_mutex_destroy(&mutex);
+	fail_mutex:
+		a3d_hashmap_discard(hashmap);
+		a3d_hashmap_delete(&hashmap);
+	fail_hashmap:
+		a3d_sharedmap_discard(sharedmap);
+		a3d_sharedmap_delete(&sharedmap);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,749 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "a3d/a3d_workq.h"
+#include "a3d/a3d_timestamp.h"
+
+#define LOG_TAG "test-workq"
+#include "a3d/a3d_log.h"
+
+#define TEST_TASKS   10000
+#define TEST_THREADS 4
+#define TEST_BATCH   256
+
+// the gate holds the worker on the first task so the
+// remaining tasks stay outstanding
+static pthread_mutex_t gate_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gate_cond  = PTHREAD_COND_INITIALIZER;
+static int             gate_open  = 0;
+
+static int tasks[TEST_TASKS];
+
+static void gate(int open)
+{
+	pthread_mutex_lock(&gate_mutex);
+	gate_open = open;
+	pthread_cond_broadcast(&gate_cond);
+	pthread_mutex_unlock(&gate_mutex);
+}
+
+static int run_fn(int tid, void* owner, void* task)
+{
+	pthread_mutex_lock(&gate_mutex);
+	while(gate_open == 0)
+	{
+		pthread_cond_wait(&gate_cond, &gate_mutex);
+	}
+	pthread_mutex_unlock(&gate_mutex);
+
+	return A3D_WORKQ_COMPLETE;
+}
+
+static int run_short(int tid, void* owner, void* task)
+{
+	// a short task such as decoding a small tile
+	volatile int sum = 0;
+	int i;
+	for(i = 0; i < 1000; ++i)
+	{
+		sum += i;
+	}
+
+	return A3D_WORKQ_COMPLETE;
+}
+
+static int run_io(int tid, void* owner, void* task)
+{
+	// a task which waits on I/O such as reading a tile
+	usleep(100);
+
+	return A3D_WORKQ_COMPLETE;
+}
+
+// render simulation task which records the wait
+typedef struct
+{
+	double t_submit;
+	double wait;
+} sim_task_t;
+
+#define SIM_FRAMES 250
+#define SIM_HIGH   10
+
+static sim_task_t sim_high[SIM_FRAMES*SIM_HIGH];
+static sim_task_t sim_low[SIM_FRAMES];
+static int        sim_reset = 0;
+
+static int run_sim(int tid, void* owner, void* _task)
+{
+	sim_task_t* task = (sim_task_t*) _task;
+
+	// a 250us task such as decoding a tile
+	double t0 = a3d_timestamp();
+	task->wait = t0 - task->t_submit;
+	while(a3d_timestamp() - t0 < 0.00025)
+	{
+		// spin
+	}
+
+	return A3D_WORKQ_COMPLETE;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+	double da = *((const double*) a);
+	double db = *((const double*) b);
+	if(da < db)
+	{
+		return -1;
+	}
+	return (da > db) ? 1 : 0;
+}
+
+static void purge_sim(void* owner, void* _task, int status)
+{
+	sim_task_t* task = (sim_task_t*) _task;
+
+	// mark the tasks purged by their deadline
+	if(sim_reset == 0)
+	{
+		task->wait = -2.0;
+	}
+}
+
+static double sim_p99(sim_task_t* tasks, int count,
+                      double t_end, int* _done)
+{
+	// tasks which never ran waited at least until the end
+	// of the simulation and purged tasks are excluded
+	double* wait = (double*) malloc(count*sizeof(double));
+	if(wait == NULL)
+	{
+		return 0.0;
+	}
+
+	int i;
+	int n    = 0;
+	int done = 0;
+	for(i = 0; i < count; ++i)
+	{
+		if(tasks[i].wait == -2.0)
+		{
+			continue;
+		}
+		else if(tasks[i].wait < 0.0)
+		{
+			wait[n++] = t_end - tasks[i].t_submit;
+		}
+		else
+		{
+			wait[n++] = tasks[i].wait;
+			++done;
+		}
+	}
+
+	double p99 = 0.0;
+	if(n > 0)
+	{
+		qsort(wait, n, sizeof(double), cmp_double);
+		p99 = wait[(99*n + 99)/100 - 1];
+	}
+	free(wait);
+	*_done = done;
+	return p99;
+}
+
+static void purge_fn(void* owner, void* task, int status)
+{
+	// ignore
+}
+
+static int purge_count = 0;
+
+static void purge_counted(void* owner, void* task, int status)
+{
+	++purge_count;
+}
+
+static void lap(const char* name, int count, double* t)
+{
+	double t1 = a3d_timestamp();
+	LOGI("%s: dt=%lf, ops/s=%.0lf",
+	     name, t1 - *t, count/(t1 - *t));
+	*t = t1;
+}
+
+static int bench_outstanding(void)
+{
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, run_fn, purge_fn);
+	if(workq == NULL)
+	{
+		return 0;
+	}
+
+	gate(0);
+
+	int i;
+	double t = a3d_timestamp();
+	for(i = 0; i < TEST_TASKS; ++i)
+	{
+		a3d_workq_run(workq, (void*) &tasks[i], i%4);
+	}
+	lap("submit", TEST_TASKS, &t);
+
+	int pending = 0;
+	for(i = 0; i < TEST_TASKS; ++i)
+	{
+		if(a3d_workq_status(workq, (void*) &tasks[i]) ==
+		   A3D_WORKQ_PENDING)
+		{
+			++pending;
+		}
+	}
+	lap("status", TEST_TASKS, &t);
+
+	// resubmit at the same priority like a per frame
+	// tile request
+	for(i = 0; i < TEST_TASKS; ++i)
+	{
+		a3d_workq_run(workq, (void*) &tasks[i], i%4);
+	}
+	lap("touch", TEST_TASKS, &t);
+
+	// reprioritize like a camera move
+	for(i = 0; i < TEST_TASKS; ++i)
+	{
+		a3d_workq_run(workq, (void*) &tasks[i], (i + 1)%4);
+	}
+	lap("reprioritize", TEST_TASKS, &t);
+
+	// cancel from the tail since the head may be active
+	for(i = TEST_TASKS - 1; i >= TEST_TASKS/2; --i)
+	{
+		a3d_workq_cancel(workq, (void*) &tasks[i]);
+	}
+	lap("cancel", TEST_TASKS/2, &t);
+	LOGI("pending=%i", pending);
+
+	gate(1);
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+static int bench_batch(void)
+{
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, run_fn, purge_fn);
+	if(workq == NULL)
+	{
+		return 0;
+	}
+
+	gate(0);
+
+	// submit the tasks per frame in batches
+	int   i;
+	int   j;
+	void* batch[TEST_BATCH];
+	int   priorities[TEST_BATCH];
+	int   status[TEST_BATCH];
+	double t = a3d_timestamp();
+	for(i = 0; i < TEST_TASKS; i += TEST_BATCH)
+	{
+		int count = TEST_BATCH;
+		if(i + count > TEST_TASKS)
+		{
+			count = TEST_TASKS - i;
+		}
+
+		for(j = 0; j < count; ++j)
+		{
+			batch[j]      = (void*) &tasks[i + j];
+			priorities[j] = (i + j)%4;
+		}
+		a3d_workq_runBatch(workq, batch, priorities, count, status);
+	}
+	lap("submit batch", TEST_TASKS, &t);
+
+	gate(1);
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+static int bench_throughput(int stealing)
+{
+	a3d_workq_t* workq;
+	if(stealing)
+	{
+		workq = a3d_workq_newStealing(NULL, TEST_THREADS,
+		                              run_short, purge_fn);
+	}
+	else
+	{
+		workq = a3d_workq_new(NULL, TEST_THREADS,
+		                      run_short, purge_fn);
+	}
+
+	if(workq == NULL)
+	{
+		return 0;
+	}
+
+	int i;
+	double t = a3d_timestamp();
+	for(i = 0; i < TEST_TASKS; ++i)
+	{
+		a3d_workq_run(workq, (void*) &tasks[i], i%4);
+	}
+
+	while(a3d_workq_pending(workq) > 0)
+	{
+		usleep(100);
+	}
+	lap(stealing ? "throughput stealing" : "throughput mutex",
+	    TEST_TASKS, &t);
+
+	// purge the complete queue
+	a3d_workq_purge(workq);
+	a3d_workq_purge(workq);
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+static int bench_complete(int drain)
+{
+	a3d_workq_t* workq = a3d_workq_new(NULL, TEST_THREADS,
+	                                   run_io, purge_fn);
+	if(workq == NULL)
+	{
+		return 0;
+	}
+
+	int i;
+	for(i = 0; i < TEST_TASKS; ++i)
+	{
+		a3d_workq_run(workq, (void*) &tasks[i], i%4);
+	}
+
+	// simulate frames which collect the completed tasks
+	// and measure the time spent by the main thread
+	int    frames    = 0;
+	int    collected = 0;
+	int    done[TEST_TASKS] = { 0 };
+	double dt = 0.0;
+	while(collected < TEST_TASKS)
+	{
+		double t0 = a3d_timestamp();
+		if(drain)
+		{
+			void* batch[TEST_BATCH];
+			int   count;
+			while((count = a3d_workq_drain(workq, batch, NULL,
+			                               TEST_BATCH)) > 0)
+			{
+				collected += count;
+			}
+		}
+		else
+		{
+			for(i = 0; i < TEST_TASKS; ++i)
+			{
+				if(done[i] == 0)
+				{
+					if(a3d_workq_run(workq, (void*) &tasks[i],
+					                 i%4) == A3D_WORKQ_COMPLETE)
+					{
+						done[i] = 1;
+						++collected;
+					}
+				}
+			}
+		}
+		dt += a3d_timestamp() - t0;
+		++frames;
+
+		usleep(1000);
+	}
+
+	LOGI("%s: frames=%i, main thread dt=%lf",
+	     drain ? "complete drain" : "complete poll", frames, dt);
+
+	// queueing versus run time
+	a3d_workqstats_t stats;
+	double           utilization[TEST_THREADS];
+	a3d_workq_stats(workq, &stats, utilization);
+	LOGI("wait: p50=%lf, p95=%lf, p99=%lf",
+	     stats.wait.p50, stats.wait.p95, stats.wait.p99);
+	LOGI("run: p50=%lf, p95=%lf, p99=%lf",
+	     stats.run.p50, stats.run.p95, stats.run.p99);
+	LOGI("collect: p50=%lf, p95=%lf, p99=%lf",
+	     stats.collect.p50, stats.collect.p95, stats.collect.p99);
+	LOGI("depth: p50=%.0lf, max=%.0lf, throughput=%.0lf",
+	     stats.depth.p50, stats.depth.max, stats.throughput);
+	for(i = 0; i < TEST_THREADS; ++i)
+	{
+		LOGI("utilization[%i]=%lf", i, utilization[i]);
+	}
+
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+static int bench_dynamic(int dynamic)
+{
+	a3d_workq_t* workq;
+	if(dynamic)
+	{
+		workq = a3d_workq_newDynamic(NULL, 1, TEST_THREADS,
+		                             run_io, purge_fn);
+	}
+	else
+	{
+		workq = a3d_workq_new(NULL, 1, run_io, purge_fn);
+	}
+
+	if(workq == NULL)
+	{
+		return 0;
+	}
+	a3d_workq_scaling(workq, 4, 0.01, 0.05);
+
+	// bursts of tasks separated by idle periods
+	int i;
+	int j;
+	int peak = 0;
+	a3d_workqstats_t stats;
+	for(j = 0; j < 3; ++j)
+	{
+		for(i = 0; i < TEST_TASKS/10; ++i)
+		{
+			a3d_workq_run(workq, (void*) &tasks[i], i%4);
+		}
+
+		while(a3d_workq_pending(workq) > 0)
+		{
+			a3d_workq_stats(workq, &stats, NULL);
+			if(stats.threads > peak)
+			{
+				peak = stats.threads;
+			}
+			usleep(1000);
+		}
+		a3d_workq_purge(workq);
+		a3d_workq_purge(workq);
+
+		usleep(200000);
+	}
+
+	a3d_workq_stats(workq, &stats, NULL);
+	LOGI("%s: peak=%i, idle=%i, wait p99=%lf",
+	     dynamic ? "dynamic" : "fixed", peak, stats.threads,
+	     stats.wait.p99);
+
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+static int bench_pool(int shared)
+{
+	// six subsystems each with their own workq
+	a3d_workqpool_t* pool = NULL;
+	if(shared)
+	{
+		pool = a3d_workqpool_new(0);
+		if(pool == NULL)
+		{
+			return 0;
+		}
+	}
+
+	int i;
+	int q;
+	int threads = 0;
+	a3d_workq_t* workq[6];
+	for(q = 0; q < 6; ++q)
+	{
+		if(shared)
+		{
+			workq[q] = a3d_workq_newShared(NULL, pool, 0, 1,
+			                               run_short, purge_fn);
+			threads  = pool->thread_count;
+		}
+		else
+		{
+			workq[q] = a3d_workq_new(NULL, 1, run_short, purge_fn);
+			threads += 1;
+		}
+
+		if(workq[q] == NULL)
+		{
+			return 0;
+		}
+	}
+
+	double t = a3d_timestamp();
+	for(i = 0; i < TEST_TASKS; ++i)
+	{
+		a3d_workq_run(workq[i%6], (void*) &tasks[i], i%4);
+	}
+
+	for(q = 0; q < 6; ++q)
+	{
+		while(a3d_workq_pending(workq[q]) > 0)
+		{
+			usleep(100);
+		}
+	}
+	LOGI("%s: threads=%i", shared ? "pool shared" : "pool dedicated",
+	     threads);
+	lap(shared ? "pool shared" : "pool dedicated", TEST_TASKS, &t);
+
+	for(q = 0; q < 6; ++q)
+	{
+		a3d_workq_delete(&workq[q]);
+	}
+	a3d_workqpool_delete(&pool);
+
+	return 1;
+}
+
+static int bench_aging(int aging, int deadline)
+{
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, run_sim, purge_sim);
+	if(workq == NULL)
+	{
+		return 0;
+	}
+
+	// low priority tasks overtake new high priority tasks
+	// after waiting for 30ms and high priority tasks are
+	// purged after 50ms
+	if(aging)
+	{
+		a3d_workq_aging(workq, 0.01);
+	}
+	a3d_workq_expire(workq, A3D_WORKQ_EXPIRE_PURGE);
+
+	// the render thread submits 125% of the capacity as
+	// high priority tiles each 2ms frame along with a low
+	// priority tile
+	int i;
+	int j;
+	double t0 = a3d_timestamp();
+	for(j = 0; j < SIM_FRAMES; ++j)
+	{
+		double t = a3d_timestamp();
+		for(i = 0; i < SIM_HIGH; ++i)
+		{
+			sim_task_t* task = &sim_high[j*SIM_HIGH + i];
+			task->t_submit = t;
+			task->wait     = -1.0;
+			if(deadline)
+			{
+				a3d_workq_runDeadline(workq, (void*) task, 3, 0.05);
+			}
+			else
+			{
+				a3d_workq_run(workq, (void*) task, 3);
+			}
+		}
+
+		sim_low[j].t_submit = t;
+		sim_low[j].wait     = -1.0;
+		a3d_workq_run(workq, (void*) &sim_low[j], 0);
+
+		usleep(2000);
+	}
+
+	// stop the simulation
+	double t_end = a3d_timestamp();
+	sim_reset = 1;
+	a3d_workq_reset(workq, 1);
+	sim_reset = 0;
+
+	a3d_workqstats_t stats;
+	a3d_workq_stats(workq, &stats, NULL);
+
+	int    done_high;
+	int    done_low;
+	double p99_high = sim_p99(sim_high, SIM_FRAMES*SIM_HIGH,
+	                          t_end, &done_high);
+	double p99_low  = sim_p99(sim_low, SIM_FRAMES,
+	                          t_end, &done_low);
+	LOGI("aging=%i, deadline=%i: dt=%lf, expired=%i",
+	     aging, deadline, t_end - t0, (int) stats.expired);
+	LOGI("high: done=%i/%i, wait p99=%lf",
+	     done_high, SIM_FRAMES*SIM_HIGH, p99_high);
+	LOGI("low:  done=%i/%i, wait p99=%lf",
+	     done_low, SIM_FRAMES, p99_low);
+
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+static int bench_epochs(int epochs)
+{
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, run_fn,
+	                                   purge_counted);
+	if(workq == NULL)
+	{
+		return 0;
+	}
+
+	gate(0);
+
+	// a fast pan back and forth over a row of tiles where
+	// the 64 visible tiles move by 16 tiles per frame
+	int i;
+	int j;
+	purge_count = 0;
+	double t = a3d_timestamp();
+	for(j = 0; j < 1000; ++j)
+	{
+		int x = 16*(j%8);
+		if(x > 64)
+		{
+			x = 128 - x;
+		}
+
+		for(i = x; i < x + 64; ++i)
+		{
+			a3d_workq_run(workq, (void*) &tasks[i], 0);
+		}
+		a3d_workq_purgeOlderThan(workq, epochs);
+	}
+	lap(epochs == 1 ? "purge" : "purgeOlderThan", 64*1000, &t);
+	LOGI("epochs=%i, purged=%i", epochs, purge_count);
+
+	gate(1);
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+static int bench_chain(int deps)
+{
+	a3d_workq_t* workq = a3d_workq_new(NULL, TEST_THREADS,
+	                                   run_short, purge_fn);
+	if(workq == NULL)
+	{
+		return 0;
+	}
+
+	// 64 tiles each loaded by a fetch, decompress, decode
+	// and mesh build chain where the render thread
+	// checks the stages each 2ms frame
+	int i;
+	int k;
+	int stage[64];
+	int frames = 0;
+	for(i = 0; i < 64; ++i)
+	{
+		stage[i] = 0;
+		if(deps)
+		{
+			a3d_workq_run(workq, (void*) &tasks[4*i], 0);
+			for(k = 1; k < 4; ++k)
+			{
+				void* prereq = (void*) &tasks[4*i + k - 1];
+				a3d_workq_runAfter(workq, (void*) &tasks[4*i + k],
+				                   0, &prereq, 1);
+			}
+			stage[i] = 3;
+		}
+		else
+		{
+			a3d_workq_run(workq, (void*) &tasks[4*i], 0);
+		}
+	}
+
+	double t    = a3d_timestamp();
+	int    done = 0;
+	while(done < 64)
+	{
+		usleep(2000);
+		++frames;
+
+		done = 0;
+		for(i = 0; i < 64; ++i)
+		{
+			void* task = (void*) &tasks[4*i + stage[i]];
+			if(a3d_workq_status(workq, task) != A3D_WORKQ_COMPLETE)
+			{
+				continue;
+			}
+			else if(stage[i] == 3)
+			{
+				++done;
+				continue;
+			}
+
+			// submit the next stage
+			a3d_workq_run(workq, task, 0);
+			++stage[i];
+			a3d_workq_run(workq, (void*) &tasks[4*i + stage[i]], 0);
+		}
+	}
+	lap(deps ? "chain runAfter" : "chain resubmit", 4*64, &t);
+	LOGI("%s: frames=%i", deps ? "runAfter" : "resubmit", frames);
+
+	a3d_workq_delete(&workq);
+
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	if((bench_outstanding() == 0) ||
+	   (bench_batch()       == 0) ||
+	   (bench_throughput(0) == 0) ||
+	   (bench_throughput(1) == 0) ||
+	   (bench_complete(0)   == 0) ||
+	   (bench_complete(1)   == 0) ||
+	   (bench_dynamic(0)    == 0) ||
+	   (bench_dynamic(1)    == 0) ||
+	   (bench_pool(0)       == 0) ||
+	   (bench_pool(1)       == 0) ||
+	   (bench_aging(0, 0)   == 0) ||
+	   (bench_aging(1, 0)   == 0) ||
+	   (bench_aging(0, 1)   == 0) ||
+	   (bench_aging(1, 1)   == 0) ||
+	   (bench_epochs(1)     == 0) ||
+	   (bench_epochs(8)     == 0) ||
+	   (bench_chain(0)      == 0) ||
+	   (bench_chain(1)      == 0))
+	{
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
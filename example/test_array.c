@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "test_array.h"
+#include "a3d/a3d_array.h"
+
+#define LOG_TAG "test_array"
+#include "a3d/a3d_log.h"
+
+static int compare(const void* _a, const void* _b)
+{
+	const int* a = (const int*) _a;
+	const int* b = (const int*) _b;
+	if(*a == *b)
+	{
+		return 0;
+	}
+	else if(*a > *b)
+	{
+		return 1;
+	}
+	return -1;
+}
+
+static void testeq(int a, int b)
+{
+	if(a == b)
+	{
+		LOGI("[pass] %i %i", a, b);
+	}
+	else
+	{
+		LOGI("[fail] %i %i", a, b);
+	}
+}
+
+void test_array(void)
+{
+	int i;
+	int x;
+
+	a3d_array_t* array = a3d_array_new(sizeof(int));
+	if(array == NULL)
+	{
+		return;
+	}
+
+	// test push/pop
+	{
+		LOGI("PUSH/POP");
+		for(i = 0; i < 100; ++i)
+		{
+			a3d_array_push(array, &i);
+		}
+
+		testeq(100, a3d_array_size(array));
+		testeq(0, a3d_array_empty(array));
+		testeq(1, array->capacity >= 100);
+
+		for(i = 99; i >= 0; --i)
+		{
+			a3d_array_pop(array, &x);
+			testeq(i, x);
+		}
+
+		testeq(1, a3d_array_empty(array));
+		testeq(0, a3d_array_pop(array, &x));
+	}
+
+	// test reserve/append/get/data
+	{
+		LOGI("RESERVE/APPEND/GET/DATA");
+		int elems[4] = { 3, 1, 2, 0 };
+		a3d_array_reserve(array, 1000);
+		testeq(1000, array->capacity);
+
+		a3d_array_append(array, 4, elems);
+		a3d_array_append(array, 4, elems);
+		testeq(8, a3d_array_size(array));
+		testeq(3, *((int*) a3d_array_get(array, 4)));
+		testeq(0, *((int*) a3d_array_peektail(array)));
+
+		int* data = (int*) a3d_array_data(array);
+		testeq(1, data[5]);
+		testeq(1000, array->capacity);
+	}
+
+	// test sort
+	{
+		LOGI("SORT");
+		a3d_array_sort(array, compare);
+
+		int* data = (int*) a3d_array_data(array);
+		for(i = 0; i < 8; ++i)
+		{
+			testeq(i/2, data[i]);
+		}
+
+		a3d_array_clear(array);
+		testeq(1, a3d_array_empty(array));
+	}
+
+	a3d_array_delete(&array);
+}
@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include "test_cache.h"
 #include "a3d/a3d_cache.h"
+#include "a3d/a3d_timestamp.h"
 
 #define LOG_TAG "test_cache"
 #include "a3d/a3d_log.h"
@@ -50,6 +51,7 @@ static void testeq(int a, int b)
 #define TEST_STORE_ERROR       6   // status/test
 #define TEST_EVICT_BEFORE_LOAD 7   // test
 #define TEST_EVICT_AFTER_STORE 8   // test
+#define TEST_EVICT_DURING_LOAD 9   // test
 
 typedef struct
 {
@@ -140,6 +142,10 @@ static void test_evict_fn(void* _item)
 	{
 		testeq(item->status, TEST_STORED);
 	}
+	else if(item->test == TEST_EVICT_DURING_LOAD)
+	{
+		testeq(item->status, TEST_LOADED);
+	}
 	else
 	{
 		LOGI("[fail] unknown test=%i", item->test);
@@ -242,4 +248,85 @@ void test_cache(void)
 		test_item_delete(&f);
 		test_item_delete(&g);
 	}
+
+	// test unregister during load
+	{
+		LOGI("unregister");
+
+		a3d_cache_t* cache = a3d_cache_new(3,
+		                                   test_load_fn,
+		                                   test_store_fn,
+		                                   test_evict_fn);
+		if(cache == NULL)
+		{
+			return;
+		}
+
+		test_item_t* h = test_item_new('h', TEST_EVICT_DURING_LOAD);
+		h->key = a3d_cache_register(cache, h);
+		testeq(a3d_cache_request(cache, h->key), A3D_CACHE_MISS);
+
+		// unregister returns without waiting for the load
+		// and evicts h on the next purge once loaded
+		usleep(50000);
+		double t0 = a3d_timestamp();
+		a3d_cache_unregister(cache, h->key);
+		testeq(a3d_timestamp() - t0 < 0.025, 1);
+
+		usleep(200000);
+		a3d_cache_purge(cache);
+		testeq(h->status, TEST_EVICTED);
+
+		a3d_cache_delete(&cache);
+		test_item_delete(&h);
+	}
+
+	// test shared pool
+	{
+		LOGI("shared");
+
+		a3d_workqpool_t* pool = a3d_workqpool_new(3);
+		if(pool == NULL)
+		{
+			return;
+		}
+
+		a3d_cache_t* cache = a3d_cache_newShared(3, pool, 0, 1,
+		                                         test_load_fn,
+		                                         test_store_fn,
+		                                         test_evict_fn);
+		if(cache == NULL)
+		{
+			a3d_workqpool_delete(&pool);
+			return;
+		}
+
+		test_item_t* i = test_item_new('i', TEST_EVICT_AFTER_STORE);
+		test_item_t* j = test_item_new('j', TEST_EVICT_AFTER_STORE);
+		test_item_t* k = test_item_new('k', TEST_EVICT_AFTER_STORE);
+
+		i->key = a3d_cache_register(cache, i);
+		j->key = a3d_cache_register(cache, j);
+		k->key = a3d_cache_register(cache, k);
+
+		testeq(a3d_cache_request(cache, i->key), A3D_CACHE_MISS);
+		testeq(a3d_cache_request(cache, j->key), A3D_CACHE_MISS);
+		testeq(a3d_cache_request(cache, k->key), A3D_CACHE_MISS);
+
+		// the loads run concurrently on the pool
+		usleep(200000);
+		a3d_cache_purge(cache);
+
+		testeq(a3d_cache_request(cache, i->key), A3D_CACHE_HIT);
+		testeq(a3d_cache_request(cache, j->key), A3D_CACHE_HIT);
+		testeq(a3d_cache_request(cache, k->key), A3D_CACHE_HIT);
+
+		// evict i, j, k
+		a3d_cache_delete(&cache);
+		a3d_workqpool_delete(&pool);
+
+		test_item_delete(&i);
+		test_item_delete(&j);
+		test_item_delete(&k);
+	}
 }
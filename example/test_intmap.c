@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "test_intmap.h"
+#include "a3d/a3d_intmap.h"
+
+#define LOG_TAG "test_intmap"
+#include "a3d/a3d_log.h"
+
+static void testeq(int a, int b)
+{
+	if(a == b)
+	{
+		LOGI("[pass] %i %i", a, b);
+	}
+	else
+	{
+		LOGI("[fail] %i %i", a, b);
+	}
+}
+
+static uint64_t tile_key(int zoom, int x, int y)
+{
+	return (((uint64_t) zoom) << 48) |
+	       (((uint64_t) x)    << 24) |
+	       ((uint64_t) y);
+}
+
+void test_intmap(void)
+{
+	int i;
+	int vals[100];
+	for(i = 0; i < 100; ++i)
+	{
+		vals[i] = i;
+	}
+
+	a3d_intmap_t* intmap = a3d_intmap_new();
+	if(intmap == NULL)
+	{
+		return;
+	}
+
+	a3d_intmapIter_t  iterator;
+	a3d_intmapIter_t* iter;
+
+	// test add/find
+	{
+		LOGI("ADD/FIND");
+		for(i = 0; i < 100; ++i)
+		{
+			a3d_intmap_add(intmap, &vals[i],
+			               tile_key(10, i, 99 - i));
+		}
+
+		testeq(100, a3d_intmap_size(intmap));
+		testeq(0, a3d_intmap_add(intmap, &vals[0],
+		                         tile_key(10, 0, 99)));
+
+		const int* val;
+		val = (const int*)
+		      a3d_intmap_find(intmap, &iterator,
+		                      tile_key(10, 42, 57));
+		testeq(42, val ? *val : -1);
+		testeq(1, tile_key(10, 42, 57) ==
+		          a3d_intmap_key(&iterator));
+		testeq(1, a3d_intmap_find(intmap, &iterator,
+		                          tile_key(11, 42, 57)) == NULL);
+	}
+
+	// test iterate/remove
+	{
+		LOGI("ITERATE/REMOVE");
+		int sum   = 0;
+		int count = 0;
+		iter = a3d_intmap_head(intmap, &iterator);
+		while(iter)
+		{
+			const int* val = (const int*) a3d_intmap_val(iter);
+			sum += *val;
+			++count;
+			if(*val%2)
+			{
+				a3d_intmap_remove(intmap, &iter);
+			}
+			else
+			{
+				iter = a3d_intmap_next(iter);
+			}
+		}
+
+		testeq(100, count);
+		testeq(4950, sum);
+		testeq(50, a3d_intmap_size(intmap));
+		testeq(1, a3d_intmap_find(intmap, &iterator,
+		                          tile_key(10, 41, 58)) == NULL);
+	}
+
+	// test replace/discard
+	{
+		LOGI("REPLACE/DISCARD");
+		if(a3d_intmap_find(intmap, &iterator,
+		                   tile_key(10, 42, 57)))
+		{
+			a3d_intmap_replace(&iterator, &vals[7]);
+		}
+
+		const int* val;
+		val = (const int*)
+		      a3d_intmap_find(intmap, &iterator,
+		                      tile_key(10, 42, 57));
+		testeq(7, val ? *val : -1);
+
+		a3d_intmap_discard(intmap);
+		testeq(1, a3d_intmap_empty(intmap));
+	}
+
+	a3d_intmap_delete(&intmap);
+}
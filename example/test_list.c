@@ -44,6 +44,21 @@ static int compare(const void* _a, const void* _b)
 	return -1;
 }
 
+typedef struct
+{
+	int            x;
+	int            id;
+	a3d_listitem_t item;
+} test_node_t;
+
+static int compare_node(const void* _a, const void* _b)
+{
+	const test_node_t* a = (const test_node_t*) _a;
+	const test_node_t* b = (const test_node_t*) _b;
+	return compare((const void*) (long) a->x,
+	               (const void*) (long) b->x);
+}
+
 static void testeq(int a, int b)
 {
 	if(a == b)
@@ -175,4 +190,238 @@ void test_list(void)
 	}
 
 	a3d_list_delete(&list);
+
+	// test pooled push/pop/swap
+	{
+		LOGI("POOL");
+		a3d_listpool_t* pool = a3d_listpool_new(4);
+		if(pool == NULL)
+		{
+			return;
+		}
+
+		a3d_list_t* a = a3d_list_newPool(pool);
+		a3d_list_t* b = a3d_list_newPool(pool);
+		if((a == NULL) || (b == NULL))
+		{
+			a3d_list_delete(&a);
+			a3d_listpool_delete(&pool);
+			return;
+		}
+
+		for(i = 0; i < 10; ++i)
+		{
+			a3d_list_enqueue(a, (const void*) (i + 1));
+		}
+		testeq(3, pool->slabs);
+		testeq(10, pool->items);
+
+		a3d_list_swapn(a, b, a3d_list_head(a), NULL);
+		testeq(1, (int) a3d_list_peekhead(b));
+
+		for(i = 2; i <= 10; ++i)
+		{
+			int x = (int) a3d_list_dequeue(a);
+			testeq(i, x);
+		}
+		testeq(1, (int) a3d_list_dequeue(b));
+		testeq(0, pool->items);
+
+		// recycled items don't allocate new slabs
+		for(i = 0; i < 10; ++i)
+		{
+			a3d_list_push(a, (const void*) (i + 1));
+		}
+		testeq(3, pool->slabs);
+
+		for(i = 10; i > 0; --i)
+		{
+			int x = (int) a3d_list_pop(a);
+			testeq(i, x);
+		}
+
+		a3d_list_delete(&a);
+		a3d_list_delete(&b);
+		a3d_listpool_delete(&pool);
+	}
+
+	// test intrusive insert/append/remove
+	{
+		LOGI("INTRUSIVE");
+		a3d_list_t* intrusive = a3d_list_newIntrusive();
+		if(intrusive == NULL)
+		{
+			return;
+		}
+
+		test_node_t node[4];
+		for(i = 0; i < 4; ++i)
+		{
+			node[i].x = i;
+		}
+
+		a3d_list_appendItem(intrusive, NULL, &node[1].item, &node[1]);
+		a3d_list_appendItem(intrusive, NULL, &node[3].item, &node[3]);
+		a3d_list_insertItem(intrusive, NULL, &node[0].item, &node[0]);
+		a3d_list_insertItem(intrusive, &node[3].item,
+		                    &node[2].item, &node[2]);
+		testeq(4, a3d_list_size(intrusive));
+
+		i = 0;
+		a3d_listitem_t* item = a3d_list_head(intrusive);
+		while(item)
+		{
+			test_node_t* n;
+			n = a3d_list_container(item, test_node_t, item);
+			testeq(i, n->x);
+			testeq(i, ((test_node_t*) a3d_list_peekitem(item))->x);
+			item = a3d_list_next(item);
+			++i;
+		}
+
+		a3d_list_removeItem(intrusive, &node[2].item);
+		testeq(0, ((test_node_t*) a3d_list_pop(intrusive))->x);
+		testeq(1, ((test_node_t*) a3d_list_pop(intrusive))->x);
+		testeq(3, ((test_node_t*) a3d_list_pop(intrusive))->x);
+		testeq(1, a3d_list_empty(intrusive));
+
+		a3d_list_delete(&intrusive);
+	}
+
+	// test sort/mergeSorted
+	{
+		LOGI("SORT/MERGE");
+		a3d_list_t* a = a3d_list_new();
+		a3d_list_t* b = a3d_list_new();
+		if((a == NULL) || (b == NULL))
+		{
+			a3d_list_delete(&a);
+			return;
+		}
+
+		// sort is stable for nodes with equal x
+		test_node_t node[20];
+		for(i = 0; i < 20; ++i)
+		{
+			node[i].x  = (7*i)%5;
+			node[i].id = i;
+			a3d_list_enqueue((i < 13) ? a : b, &node[i]);
+		}
+		a3d_list_sort(a, compare_node);
+		a3d_list_sort(b, compare_node);
+		a3d_list_mergeSorted(a, b, compare_node);
+		testeq(20, a3d_list_size(a));
+		testeq(1, a3d_list_empty(b));
+
+		test_node_t* prev = NULL;
+		a3d_listitem_t* item = a3d_list_head(a);
+		while(item)
+		{
+			test_node_t* n = (test_node_t*) a3d_list_peekitem(item);
+			if(prev)
+			{
+				testeq(1, (prev->x < n->x) ||
+				          ((prev->x == n->x) && (prev->id < n->id)));
+			}
+			testeq(1, a3d_list_prev(item) ?
+			          (a3d_list_peekitem(a3d_list_prev(item)) == prev) :
+			          (prev == NULL));
+			prev = n;
+			item = a3d_list_next(item);
+		}
+		testeq(17, ((test_node_t*) a3d_list_peektail(a))->id);
+
+		a3d_list_discard(a);
+		a3d_list_delete(&a);
+		a3d_list_delete(&b);
+	}
+
+	// test index insertSorted/findSorted/remove
+	{
+		LOGI("INDEX");
+		a3d_list_t* sorted = a3d_list_new();
+		if(sorted == NULL)
+		{
+			return;
+		}
+
+		testeq(1, a3d_list_index(sorted, compare));
+		for(i = 0; i < 1000; ++i)
+		{
+			a3d_list_insertSorted(sorted, compare,
+			                      (const void*) (long) ((37*i)%1000 + 1));
+		}
+		testeq(1000, a3d_list_size(sorted));
+
+		a3d_listitem_t* item;
+		item = a3d_list_findSorted(sorted, (const void*) 500, compare);
+		testeq(500, (int) (long) a3d_list_peekitem(item));
+		a3d_list_remove(sorted, &item);
+		testeq(501, (int) (long) a3d_list_peekitem(item));
+		item = a3d_list_findSorted(sorted, (const void*) 500, compare);
+		testeq(1, item == NULL);
+
+		// sort keeps the index
+		a3d_list_sort(sorted, compare);
+		testeq(1, sorted->index != NULL);
+		item = a3d_list_findSorted(sorted, (const void*) 250, compare);
+		testeq(250, (int) (long) a3d_list_peekitem(item));
+
+		int ordered = 1;
+		for(i = 1; i <= 1000; ++i)
+		{
+			if((i != 500) &&
+			   (i != (int) (long) a3d_list_dequeue(sorted)))
+			{
+				ordered = 0;
+			}
+		}
+		testeq(1, ordered);
+		testeq(1, a3d_list_empty(sorted));
+
+		a3d_list_delete(&sorted);
+	}
+
+	// test splice out of an indexed list
+	{
+		LOGI("INDEX SPLICE");
+		a3d_list_t* a = a3d_list_new();
+		a3d_list_t* b = a3d_list_new();
+		if((a == NULL) || (b == NULL))
+		{
+			a3d_list_delete(&a);
+			return;
+		}
+
+		testeq(1, a3d_list_index(a, compare));
+		for(i = 0; i < 200; ++i)
+		{
+			a3d_list_insertSorted(a, compare,
+			                      (const void*) (long) (i + 1));
+		}
+		a3d_list_appendList(b, a);
+		testeq(200, a3d_list_size(b));
+		testeq(1, a3d_list_empty(a));
+
+		// the emptied list remains indexed
+		a3d_list_insertSorted(a, compare, (const void*) 101);
+		testeq(1, a3d_list_size(a));
+		testeq(101, (int) (long) a3d_list_peekhead(a));
+		testeq(1, a3d_list_findSorted(a, (const void*) 100,
+		                              compare) == NULL);
+		a3d_list_mergeSorted(b, a, compare);
+		testeq(201, a3d_list_size(b));
+		testeq(1, a3d_list_findSorted(a, (const void*) 101,
+		                              compare) == NULL);
+		a3d_list_insertSorted(a, compare, (const void*) 7);
+		a3d_list_insertList(b, a);
+		testeq(202, a3d_list_size(b));
+		testeq(1, a3d_list_empty(a));
+		testeq(1, a3d_list_findSorted(a, (const void*) 7,
+		                              compare) == NULL);
+
+		a3d_list_discard(b);
+		a3d_list_delete(&a);
+		a3d_list_delete(&b);
+	}
 }
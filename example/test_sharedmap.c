@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2018 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <pthread.h>
+#include "test_sharedmap.h"
+#include "a3d/a3d_sharedmap.h"
+
+#define LOG_TAG "test_sharedmap"
+#include "a3d/a3d_log.h"
+
+static void testeq(int a, int b)
+{
+	if(a == b)
+	{
+		LOGI("[pass] %i %i", a, b);
+	}
+	else
+	{
+		LOGI("[fail] %i %i", a, b);
+	}
+}
+
+static void* test_reader(void* arg)
+{
+	assert(arg);
+
+	a3d_sharedmap_t* sharedmap = (a3d_sharedmap_t*) arg;
+
+	// count the keys visible to a second reader
+	int i;
+	int count = 0;
+	a3d_sharedmap_readLock(sharedmap, 1);
+	for(i = 0; i < 100; ++i)
+	{
+		if(a3d_sharedmap_findf(sharedmap, "tile-%i", i))
+		{
+			++count;
+		}
+	}
+	a3d_sharedmap_readUnlock(sharedmap, 1);
+
+	return (void*) (long) count;
+}
+
+void test_sharedmap(void)
+{
+	int i;
+	int vals[100];
+	for(i = 0; i < 100; ++i)
+	{
+		vals[i] = i;
+	}
+
+	a3d_sharedmap_t* sharedmap = a3d_sharedmap_new(2);
+	if(sharedmap == NULL)
+	{
+		return;
+	}
+
+	// test add/find
+	{
+		LOGI("ADD/FIND");
+		for(i = 0; i < 100; ++i)
+		{
+			a3d_sharedmap_addf(sharedmap, &vals[i],
+			                   "tile-%i", i);
+		}
+
+		testeq(100, a3d_sharedmap_size(sharedmap));
+		testeq(0, a3d_sharedmap_add(sharedmap, &vals[0],
+		                            "tile-0"));
+
+		a3d_sharedmap_readLock(sharedmap, 0);
+		const int* val;
+		val = (const int*)
+		      a3d_sharedmap_find(sharedmap, "tile-42");
+		testeq(42, val ? *val : -1);
+		testeq(1, a3d_sharedmap_find(sharedmap,
+		                             "tile-100") == NULL);
+		a3d_sharedmap_readUnlock(sharedmap, 0);
+
+		pthread_t thread;
+		void*     count = NULL;
+		if(pthread_create(&thread, NULL, test_reader,
+		                  (void*) sharedmap) == 0)
+		{
+			pthread_join(thread, &count);
+		}
+		testeq(100, (int) (long) count);
+	}
+
+	// test remove/replace
+	{
+		LOGI("REMOVE/REPLACE");
+		char key[256];
+		for(i = 0; i < 100; i += 2)
+		{
+			snprintf(key, 256, "tile-%i", i);
+			a3d_sharedmap_remove(sharedmap, key);
+		}
+		testeq(50, a3d_sharedmap_size(sharedmap));
+
+		const int* old;
+		old = (const int*)
+		      a3d_sharedmap_replace(sharedmap, &vals[7],
+		                            "tile-41");
+		testeq(41, old ? *old : -1);
+		a3d_sharedmap_synchronize(sharedmap);
+
+		a3d_sharedmap_readLock(sharedmap, 0);
+		const int* val;
+		val = (const int*)
+		      a3d_sharedmap_find(sharedmap, "tile-41");
+		testeq(7, val ? *val : -1);
+		testeq(1, a3d_sharedmap_find(sharedmap,
+		                             "tile-42") == NULL);
+		a3d_sharedmap_readUnlock(sharedmap, 0);
+	}
+
+	// test discard
+	{
+		LOGI("DISCARD");
+		a3d_sharedmap_discard(sharedmap);
+		testeq(0, a3d_sharedmap_size(sharedmap));
+
+		a3d_sharedmap_readLock(sharedmap, 0);
+		testeq(1, a3d_sharedmap_find(sharedmap,
+		                             "tile-41") == NULL);
+		a3d_sharedmap_readUnlock(sharedmap, 0);
+	}
+
+	a3d_sharedmap_delete(&sharedmap);
+}
@@ -22,9 +22,12 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <pthread.h>
 #include "test_workq.h"
+#include "a3d/a3d_timestamp.h"
 #include "a3d/a3d_workq.h"
 
 #define LOG_TAG "test_workq"
@@ -80,6 +83,91 @@ static int test_run_fn(int tid, void* owner, void* _task)
 	return 1;
 }
 
+static int test_cancel_fn(int tid, void* owner, void* _task)
+{
+	// owner is the workq pointer which is set before
+	// any tasks are submitted
+	a3d_workq_t* workq = *((a3d_workq_t**) owner);
+	test_task_t* task  = (test_task_t*) _task;
+	LOGI("[%i] START: task=%p, name=%c", tid, task, task->name);
+
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		if(a3d_workq_cancelled(workq, tid))
+		{
+			LOGI("[%i] CANCEL: task=%p, name=%c", tid, task, task->name);
+			return 0;
+		}
+		usleep(10000);
+	}
+
+	LOGI("[%i] STOP:  task=%p, name=%c", tid, task, task->name);
+	return 1;
+}
+
+// order of the tasks run by the pool or workq
+static char            test_order[32];
+static int             test_order_count = 0;
+static pthread_mutex_t test_order_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void test_order_reset(void)
+{
+	pthread_mutex_lock(&test_order_mutex);
+	test_order_count = 0;
+	pthread_mutex_unlock(&test_order_mutex);
+}
+
+static int test_order_wait(char* order, int count)
+{
+	assert(order);
+	assert(count <= 32);
+
+	// wait up to 1s for count tasks to run and copy their
+	// order and return the number of tasks run
+	int i;
+	int n = 0;
+	for(i = 0; i < 100; ++i)
+	{
+		pthread_mutex_lock(&test_order_mutex);
+		n = test_order_count;
+		if(n >= count)
+		{
+			memcpy(order, test_order, count);
+		}
+		pthread_mutex_unlock(&test_order_mutex);
+
+		if(n >= count)
+		{
+			break;
+		}
+		usleep(10000);
+	}
+
+	return n;
+}
+
+static int test_order_fn(int tid, void* owner, void* _task)
+{
+	// ignore owner
+	test_task_t* task = (test_task_t*) _task;
+	LOGI("[%i] RUN: task=%p, name=%c", tid, task, task->name);
+
+	// the gate task holds the thread while tasks are submitted
+	if(task->name == 'g')
+	{
+		usleep(100000);
+	}
+
+	pthread_mutex_lock(&test_order_mutex);
+	if(test_order_count < 32)
+	{
+		test_order[test_order_count++] = task->name;
+	}
+	pthread_mutex_unlock(&test_order_mutex);
+	return 1;
+}
+
 static void test_purge_fn(void* owner, void* _task, int status)
 {
 	// ignore owner
@@ -99,16 +187,27 @@ static void testeq(int a, int b)
 	}
 }
 
-void test_workq(void)
+static void test_abx(int stealing)
 {
 	// test abx
 	{
-		LOGI("ABX");
+		LOGI("ABX: stealing=%i", stealing);
 
 		// note: tests were designed for a single thread
-		a3d_workq_t* workq = a3d_workq_new(NULL, 1,
-		                                   test_run_fn,
-		                                   test_purge_fn);
+		a3d_workq_t* workq;
+		if(stealing)
+		{
+			workq = a3d_workq_newStealing(NULL, 1,
+			                              test_run_fn,
+			                              test_purge_fn);
+		}
+		else
+		{
+			workq = a3d_workq_new(NULL, 1,
+			                      test_run_fn,
+			                      test_purge_fn);
+		}
+
 		if(workq == NULL)
 		{
 			return;
@@ -120,11 +219,11 @@ void test_workq(void)
 		test_task_t* x = test_task_new('x', 0);
 		test_task_t* y = test_task_new('y', 1);
 
-		testeq(a3d_workq_run(workq, (void*) a), A3D_WORKQ_PENDING);
-		testeq(a3d_workq_run(workq, (void*) b), A3D_WORKQ_PENDING);
-		testeq(a3d_workq_run(workq, (void*) c), A3D_WORKQ_PENDING);
-		testeq(a3d_workq_run(workq, (void*) x), A3D_WORKQ_PENDING);
-		testeq(a3d_workq_run(workq, (void*) y), A3D_WORKQ_PENDING);
+		testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+		testeq(a3d_workq_run(workq, (void*) b, 0), A3D_WORKQ_PENDING);
+		testeq(a3d_workq_run(workq, (void*) c, 0), A3D_WORKQ_PENDING);
+		testeq(a3d_workq_run(workq, (void*) x, 0), A3D_WORKQ_PENDING);
+		testeq(a3d_workq_run(workq, (void*) y, 0), A3D_WORKQ_PENDING);
 		testeq(a3d_workq_pending(workq), 5);
 
 		// cancel c
@@ -134,9 +233,9 @@ void test_workq(void)
 		usleep(150000);
 		a3d_workq_purge(workq);
 
-		testeq(a3d_workq_run(workq, (void*) a), A3D_WORKQ_COMPLETE);
-		testeq(a3d_workq_run(workq, (void*) b), A3D_WORKQ_PENDING);
-		testeq(a3d_workq_run(workq, (void*) x), A3D_WORKQ_PENDING);
+		testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_COMPLETE);
+		testeq(a3d_workq_run(workq, (void*) b, 0), A3D_WORKQ_PENDING);
+		testeq(a3d_workq_run(workq, (void*) x, 0), A3D_WORKQ_PENDING);
 		testeq(a3d_workq_pending(workq), 3);
 
 		// purge y
@@ -146,8 +245,8 @@ void test_workq(void)
 		// wait for b, x
 		usleep(200000);
 
-		testeq(a3d_workq_run(workq, (void*) b), A3D_WORKQ_COMPLETE);
-		testeq(a3d_workq_run(workq, (void*) x), A3D_WORKQ_COMPLETE);
+		testeq(a3d_workq_run(workq, (void*) b, 0), A3D_WORKQ_COMPLETE);
+		testeq(a3d_workq_run(workq, (void*) x, 0), A3D_WORKQ_COMPLETE);
 		testeq(a3d_workq_pending(workq), 0);
 
 		a3d_workq_delete(&workq);
@@ -159,3 +258,596 @@ void test_workq(void)
 		test_task_delete(&y);
 	}
 }
+
+static void test_batch(void)
+{
+	LOGI("BATCH");
+
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1,
+	                                   test_run_fn,
+	                                   test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* a = test_task_new('a', 0);
+	test_task_t* b = test_task_new('b', 0);
+	test_task_t* c = test_task_new('c', 0);
+
+	void* tasks[3]      = { (void*) a, (void*) b, (void*) c };
+	int   priorities[3] = { 0, 1, 2 };
+	int   status[3];
+
+	a3d_workq_runBatch(workq, tasks, priorities, 3, status);
+	testeq(status[0], A3D_WORKQ_PENDING);
+	testeq(status[1], A3D_WORKQ_PENDING);
+	testeq(status[2], A3D_WORKQ_PENDING);
+	testeq(a3d_workq_pending(workq), 3);
+
+	// wait for a, b, c
+	usleep(350000);
+
+	a3d_workq_runBatch(workq, tasks, priorities, 3, status);
+	testeq(status[0], A3D_WORKQ_COMPLETE);
+	testeq(status[1], A3D_WORKQ_COMPLETE);
+	testeq(status[2], A3D_WORKQ_COMPLETE);
+	testeq(a3d_workq_pending(workq), 0);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&a);
+	test_task_delete(&b);
+	test_task_delete(&c);
+}
+
+static void test_drain(void)
+{
+	LOGI("DRAIN");
+
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1,
+	                                   test_run_fn,
+	                                   test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* a = test_task_new('a', 0);
+	test_task_t* b = test_task_new('b', 0);
+	test_task_t* c = test_task_new('c', 0);
+
+	void* tasks[3]      = { (void*) a, (void*) b, (void*) c };
+	int   priorities[3] = { 0, 1, 2 };
+	int   status[3];
+
+	a3d_workq_runBatch(workq, tasks, priorities, 3, NULL);
+
+	// wait for c, b
+	usleep(250000);
+
+	void* drained[3];
+	testeq(a3d_workq_drain(workq, drained, status, 3), 2);
+	testeq(drained[0] == (void*) c, 1);
+	testeq(drained[1] == (void*) b, 1);
+	testeq(status[0], A3D_WORKQ_COMPLETE);
+	testeq(a3d_workq_status(workq, (void*) c), A3D_WORKQ_ERROR);
+
+	// wait for a
+	usleep(100000);
+
+	testeq(a3d_workq_drain(workq, drained, status, 3), 1);
+	testeq(drained[0] == (void*) a, 1);
+	testeq(a3d_workq_pending(workq), 0);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&a);
+	test_task_delete(&b);
+	test_task_delete(&c);
+}
+
+static void test_cancel(void)
+{
+	LOGI("CANCEL");
+
+	a3d_workq_t* workq = NULL;
+	workq = a3d_workq_new((void*) &workq, 1,
+	                      test_cancel_fn,
+	                      test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* a = test_task_new('a', 0);
+	test_task_t* b = test_task_new('b', 0);
+
+	// blocking cancel returns once the run_fn exits early
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+	usleep(50000);
+	double t0 = a3d_timestamp();
+	testeq(a3d_workq_cancel(workq, (void*) a), A3D_WORKQ_ERROR);
+	testeq(a3d_timestamp() - t0 < 0.5, 1);
+	testeq(a3d_workq_status(workq, (void*) a), A3D_WORKQ_ERROR);
+
+	// non-blocking cancel leaves the task for purge
+	testeq(a3d_workq_run(workq, (void*) b, 0), A3D_WORKQ_PENDING);
+	usleep(50000);
+	testeq(a3d_workq_cancelAsync(workq, (void*) b), A3D_WORKQ_PENDING);
+	usleep(50000);
+	testeq(a3d_workq_pending(workq), 0);
+
+	void* drained[1];
+	int   status[1];
+	testeq(a3d_workq_drain(workq, drained, status, 1), 0);
+	a3d_workq_purge(workq);
+	testeq(a3d_workq_status(workq, (void*) b), A3D_WORKQ_ERROR);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&a);
+	test_task_delete(&b);
+}
+
+static void test_stats(void)
+{
+	LOGI("STATS");
+
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1,
+	                                   test_run_fn,
+	                                   test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* a = test_task_new('a', 0);
+	test_task_t* b = test_task_new('b', 0);
+	test_task_t* c = test_task_new('c', 0);
+
+	void* tasks[3]      = { (void*) a, (void*) b, (void*) c };
+	int   priorities[3] = { 0, 0, 0 };
+	int   status[3];
+
+	a3d_workq_runBatch(workq, tasks, priorities, 3, NULL);
+
+	// wait for a, b, c
+	usleep(350000);
+
+	void* drained[3];
+	testeq(a3d_workq_drain(workq, drained, status, 3), 3);
+
+	a3d_workqstats_t stats;
+	double           utilization[1];
+	a3d_workq_stats(workq, &stats, utilization);
+	testeq(stats.pending + stats.active + stats.complete, 0);
+	testeq((int) stats.depth.count, 3);
+	testeq((int) stats.depth.p50, 2);
+	testeq((int) stats.run.count, 3);
+	testeq((stats.run.p50 > 0.09) && (stats.run.p50 < 0.2), 1);
+	testeq(stats.wait.p99 > 0.18, 1);
+	testeq((int) stats.collect.count, 3);
+	testeq(stats.throughput > 0.0, 1);
+	testeq(utilization[0] > 0.5, 1);
+	LOGI("wait: p50=%lf, p95=%lf, p99=%lf",
+	     stats.wait.p50, stats.wait.p95, stats.wait.p99);
+	LOGI("run: p50=%lf, throughput=%lf, utilization=%lf",
+	     stats.run.p50, stats.throughput, utilization[0]);
+
+	a3d_workq_statsReset(workq);
+	a3d_workq_stats(workq, &stats, NULL);
+	testeq((int) stats.run.count, 0);
+	testeq((int) stats.collect.count, 0);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&a);
+	test_task_delete(&b);
+	test_task_delete(&c);
+}
+
+static void test_dynamic(void)
+{
+	LOGI("DYNAMIC");
+
+	a3d_workq_t* workq = a3d_workq_newDynamic(NULL, 0, 2,
+	                                          test_run_fn,
+	                                          test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+	a3d_workq_scaling(workq, 1, 0.01, 0.2);
+
+	a3d_workqstats_t stats;
+	a3d_workq_stats(workq, &stats, NULL);
+	testeq(stats.threads, 0);
+
+	test_task_t* a = test_task_new('a', 0);
+	test_task_t* b = test_task_new('b', 0);
+	test_task_t* c = test_task_new('c', 0);
+	test_task_t* d = test_task_new('d', 0);
+
+	void* tasks[4]      = { (void*) a, (void*) b,
+	                        (void*) c, (void*) d };
+	int   priorities[4] = { 0, 0, 0, 0 };
+	int   status[4];
+
+	// the backlog adds threads up to the maximum
+	a3d_workq_runBatch(workq, tasks, priorities, 4, NULL);
+	usleep(50000);
+	a3d_workq_stats(workq, &stats, NULL);
+	testeq(stats.threads, 2);
+
+	// wait for a, b, c, d
+	usleep(250000);
+	void* drained[4];
+	testeq(a3d_workq_drain(workq, drained, status, 4), 4);
+
+	// idle threads retire after the timeout
+	usleep(300000);
+	a3d_workq_stats(workq, &stats, NULL);
+	testeq(stats.threads, 0);
+
+	// threads are added again on demand
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+	usleep(150000);
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_COMPLETE);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&a);
+	test_task_delete(&b);
+	test_task_delete(&c);
+	test_task_delete(&d);
+}
+
+static void test_pool(void)
+{
+	LOGI("POOL");
+
+	a3d_workqpool_t* pool = a3d_workqpool_new(1);
+	if(pool == NULL)
+	{
+		return;
+	}
+
+	// gate has the highest priority and a has 3x the
+	// weight of b
+	a3d_workq_t* g;
+	a3d_workq_t* a;
+	a3d_workq_t* b;
+	g = a3d_workq_newShared(NULL, pool, 1, 1,
+	                        test_order_fn, test_purge_fn);
+	a = a3d_workq_newShared(NULL, pool, 0, 3,
+	                        test_order_fn, test_purge_fn);
+	b = a3d_workq_newShared(NULL, pool, 0, 1,
+	                        test_order_fn, test_purge_fn);
+	if((g == NULL) || (a == NULL) || (b == NULL))
+	{
+		goto fail_workq;
+	}
+
+	test_task_t* tg = test_task_new('g', 0);
+	test_task_t* tx = test_task_new('x', 0);
+	test_task_t* ta[8];
+	test_task_t* tb[8];
+	int i;
+	for(i = 0; i < 8; ++i)
+	{
+		ta[i] = test_task_new('a', 0);
+		tb[i] = test_task_new('b', 0);
+	}
+
+	test_order_reset();
+	testeq(a3d_workq_run(g, (void*) tg, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	for(i = 0; i < 8; ++i)
+	{
+		a3d_workq_run(b, (void*) tb[i], 0);
+		a3d_workq_run(a, (void*) ta[i], 0);
+	}
+	testeq(a3d_workq_run(g, (void*) tx, 0), A3D_WORKQ_PENDING);
+
+	// wait for the tasks
+	char order[32];
+	testeq(test_order_wait(order, 18), 18);
+	testeq(a3d_workq_pending(a) + a3d_workq_pending(b), 0);
+
+	// x has priority over a and b which share the pool in
+	// proportion to their weight
+	testeq(order[0], 'g');
+	testeq(order[1], 'x');
+	int count_a = 0;
+	for(i = 2; i < 10; ++i)
+	{
+		if(order[i] == 'a')
+		{
+			++count_a;
+		}
+	}
+	testeq(count_a, 6);
+
+	a3d_workq_delete(&g);
+	a3d_workq_delete(&a);
+	a3d_workq_delete(&b);
+	a3d_workqpool_delete(&pool);
+
+	test_task_delete(&tg);
+	test_task_delete(&tx);
+	for(i = 0; i < 8; ++i)
+	{
+		test_task_delete(&ta[i]);
+		test_task_delete(&tb[i]);
+	}
+	return;
+
+	// failure
+	fail_workq:
+		a3d_workq_delete(&g);
+		a3d_workq_delete(&a);
+		a3d_workq_delete(&b);
+		a3d_workqpool_delete(&pool);
+}
+
+static void test_aging(void)
+{
+	LOGI("AGING");
+
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, test_order_fn,
+	                                   test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* g = test_task_new('g', 0);
+	test_task_t* l = test_task_new('l', 0);
+	test_task_t* h = test_task_new('h', 0);
+
+	// l waits for 5 intervals which raises it above h
+	char order[32];
+	a3d_workq_aging(workq, 0.01);
+	test_order_reset();
+	testeq(a3d_workq_run(workq, (void*) g, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	testeq(a3d_workq_run(workq, (void*) l, 0), A3D_WORKQ_PENDING);
+	usleep(50000);
+	testeq(a3d_workq_run(workq, (void*) h, 2), A3D_WORKQ_PENDING);
+	testeq(test_order_wait(order, 3), 3);
+	testeq(order[1], 'l');
+	testeq(order[2], 'h');
+	a3d_workq_reset(workq, 1);
+
+	// h runs first without aging
+	a3d_workq_aging(workq, 0.0);
+	test_order_reset();
+	testeq(a3d_workq_run(workq, (void*) g, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	testeq(a3d_workq_run(workq, (void*) l, 0), A3D_WORKQ_PENDING);
+	usleep(50000);
+	testeq(a3d_workq_run(workq, (void*) h, 2), A3D_WORKQ_PENDING);
+	testeq(test_order_wait(order, 3), 3);
+	testeq(order[1], 'h');
+	testeq(order[2], 'l');
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&g);
+	test_task_delete(&l);
+	test_task_delete(&h);
+}
+
+static void test_deadline(void)
+{
+	LOGI("DEADLINE");
+
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, test_order_fn,
+	                                   test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* g = test_task_new('g', 0);
+	test_task_t* d = test_task_new('d', 0);
+	test_task_t* h = test_task_new('h', 0);
+	test_task_t* x = test_task_new('x', 0);
+
+	// d is promoted above h once the deadline passes
+	char order[32];
+	test_order_reset();
+	testeq(a3d_workq_run(workq, (void*) g, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	testeq(a3d_workq_runDeadline(workq, (void*) d, 0, 0.02),
+	       A3D_WORKQ_PENDING);
+	testeq(a3d_workq_run(workq, (void*) h, 1), A3D_WORKQ_PENDING);
+	usleep(50000);
+	testeq(a3d_workq_run(workq, (void*) x, 0), A3D_WORKQ_PENDING);
+	testeq(test_order_wait(order, 4), 4);
+	testeq(order[1], 'd');
+	testeq(order[2], 'h');
+	testeq(order[3], 'x');
+	a3d_workq_reset(workq, 1);
+
+	// d is purged once the deadline passes
+	a3d_workq_expire(workq, A3D_WORKQ_EXPIRE_PURGE);
+	a3d_workq_statsReset(workq);
+	test_order_reset();
+	testeq(a3d_workq_run(workq, (void*) g, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	testeq(a3d_workq_runDeadline(workq, (void*) d, 0, 0.02),
+	       A3D_WORKQ_PENDING);
+	usleep(50000);
+	testeq(a3d_workq_run(workq, (void*) x, 0), A3D_WORKQ_PENDING);
+	testeq(a3d_workq_status(workq, (void*) d), A3D_WORKQ_ERROR);
+	testeq(test_order_wait(order, 2), 2);
+	testeq(order[1], 'x');
+
+	a3d_workqstats_t stats;
+	a3d_workq_stats(workq, &stats, NULL);
+	testeq((int) stats.expired, 1);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&g);
+	test_task_delete(&d);
+	test_task_delete(&h);
+	test_task_delete(&x);
+}
+
+static void test_epochs(void)
+{
+	LOGI("EPOCHS");
+
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, test_order_fn,
+	                                   test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* g = test_task_new('g', 0);
+	test_task_t* a = test_task_new('a', 0);
+	test_task_t* b = test_task_new('b', 0);
+
+	// a and b are pending while g runs
+	char order[32];
+	test_order_reset();
+	testeq(a3d_workq_run(workq, (void*) g, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+	testeq(a3d_workq_run(workq, (void*) b, 0), A3D_WORKQ_PENDING);
+
+	// b is kept for 3 epochs and a is run again in the
+	// second epoch
+	a3d_workq_purgeOlderThan(workq, 3);
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+	a3d_workq_purgeOlderThan(workq, 3);
+	a3d_workq_purgeOlderThan(workq, 3);
+	testeq(a3d_workq_status(workq, (void*) b), A3D_WORKQ_PENDING);
+	a3d_workq_purgeOlderThan(workq, 3);
+	testeq(a3d_workq_status(workq, (void*) b), A3D_WORKQ_ERROR);
+	testeq(a3d_workq_status(workq, (void*) a), A3D_WORKQ_PENDING);
+
+	// a single epoch is the same as purge
+	a3d_workq_purge(workq);
+	testeq(a3d_workq_status(workq, (void*) a), A3D_WORKQ_ERROR);
+	usleep(200000);
+	testeq(test_order_wait(order, 1), 1);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&g);
+	test_task_delete(&a);
+	test_task_delete(&b);
+}
+
+static void test_deps(void)
+{
+	LOGI("DEPS");
+
+	a3d_workq_t* workq = a3d_workq_new(NULL, 1, test_order_fn,
+	                                   test_purge_fn);
+	if(workq == NULL)
+	{
+		return;
+	}
+
+	test_task_t* g = test_task_new('g', 0);
+	test_task_t* a = test_task_new('a', 0);
+	test_task_t* b = test_task_new('b', 0);
+	test_task_t* c = test_task_new('c', 0);
+	test_task_t* x = test_task_new('x', 0);
+
+	// b and c wait for a despite the higher priority
+	void* deps_b[1] = { (void*) a };
+	void* deps_c[2] = { (void*) a, (void*) b };
+	char  order[32];
+	test_order_reset();
+	testeq(a3d_workq_run(workq, (void*) g, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+	testeq(a3d_workq_runAfter(workq, (void*) b, 5, deps_b, 1),
+	       A3D_WORKQ_PENDING);
+	testeq(a3d_workq_runAfter(workq, (void*) c, 5, deps_c, 2),
+	       A3D_WORKQ_PENDING);
+	testeq(a3d_workq_run(workq, (void*) x, 1), A3D_WORKQ_PENDING);
+
+	a3d_workqstats_t stats;
+	a3d_workq_stats(workq, &stats, NULL);
+	testeq(stats.blocked, 2);
+	testeq(a3d_workq_status(workq, (void*) c), A3D_WORKQ_PENDING);
+
+	// wait for c to complete before reading the order
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		if(a3d_workq_status(workq, (void*) c) != A3D_WORKQ_PENDING)
+		{
+			break;
+		}
+		usleep(10000);
+	}
+	testeq(a3d_workq_status(workq, (void*) c), A3D_WORKQ_COMPLETE);
+	testeq(test_order_wait(order, 5), 5);
+	testeq(order[1], 'x');
+	testeq(order[2], 'a');
+	testeq(order[3], 'b');
+	testeq(order[4], 'c');
+	a3d_workq_reset(workq, 1);
+
+	// cancel propagates to the dependents
+	test_order_reset();
+	testeq(a3d_workq_run(workq, (void*) g, 0), A3D_WORKQ_PENDING);
+	usleep(20000);
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+	testeq(a3d_workq_runAfter(workq, (void*) b, 0, deps_b, 1),
+	       A3D_WORKQ_PENDING);
+	testeq(a3d_workq_runAfter(workq, (void*) c, 0, deps_c, 2),
+	       A3D_WORKQ_PENDING);
+	testeq(a3d_workq_cancel(workq, (void*) a), A3D_WORKQ_PENDING);
+	testeq(a3d_workq_status(workq, (void*) b), A3D_WORKQ_ERROR);
+	testeq(a3d_workq_status(workq, (void*) c), A3D_WORKQ_ERROR);
+	testeq(a3d_workq_pending(workq), 1);
+
+	// running b keeps a from being purged and purging a
+	// purges b
+	testeq(a3d_workq_run(workq, (void*) a, 0), A3D_WORKQ_PENDING);
+	testeq(a3d_workq_runAfter(workq, (void*) b, 0, deps_b, 1),
+	       A3D_WORKQ_PENDING);
+	a3d_workq_purge(workq);
+	testeq(a3d_workq_run(workq, (void*) b, 0), A3D_WORKQ_PENDING);
+	a3d_workq_purge(workq);
+	testeq(a3d_workq_status(workq, (void*) a), A3D_WORKQ_PENDING);
+	a3d_workq_purge(workq);
+	testeq(a3d_workq_status(workq, (void*) a), A3D_WORKQ_ERROR);
+	testeq(a3d_workq_status(workq, (void*) b), A3D_WORKQ_ERROR);
+	usleep(200000);
+	testeq(test_order_wait(order, 1), 1);
+
+	a3d_workq_delete(&workq);
+
+	test_task_delete(&g);
+	test_task_delete(&a);
+	test_task_delete(&b);
+	test_task_delete(&c);
+	test_task_delete(&x);
+}
+
+void test_workq(void)
+{
+	test_abx(0);
+	test_abx(1);
+	test_batch();
+	test_drain();
+	test_cancel();
+	test_stats();
+	test_dynamic();
+	test_pool();
+	test_aging();
+	test_deadline();
+	test_epochs();
+	test_deps();
+}
@@ -44,7 +44,7 @@ a3d_stack4f_t* a3d_stack4f_new(void)
 		return NULL;
 	}
 
-	self->matrix_stack = a3d_list_new();
+	self->matrix_stack = a3d_array_new(sizeof(a3d_mat4f_t));
 	if(self->matrix_stack == NULL)
 		goto fail_matrix_stack;
 
@@ -67,13 +67,7 @@ void a3d_stack4f_delete(a3d_stack4f_t** _self)
 	{
 		LOGD("debug");
 
-		a3d_mat4f_t* m = (a3d_mat4f_t*) a3d_list_pop(self->matrix_stack);
-		while(m)
-		{
-			free(m);
-			m = (a3d_mat4f_t*) a3d_list_pop(self->matrix_stack);
-		}
-		a3d_list_delete(&self->matrix_stack);
+		a3d_array_delete(&self->matrix_stack);
 		free(self);
 		*_self = NULL;
 	}
@@ -85,14 +79,7 @@ void a3d_stack4f_push(a3d_stack4f_t* self, const a3d_mat4f_t* m)
 	assert(m);
 	LOGD("debug");
 
-	a3d_mat4f_t* c = (a3d_mat4f_t*) malloc(sizeof(a3d_mat4f_t));
-	if(c == NULL)
-	{
-		LOGE("malloc failed");
-		return;
-	}
-	a3d_mat4f_copy(m, c);
-	a3d_list_push(self->matrix_stack, (const void*) c);
+	a3d_array_push(self->matrix_stack, (const void*) m);
 }
 
 void a3d_stack4f_pop(a3d_stack4f_t* self, a3d_mat4f_t* m)
@@ -101,9 +88,5 @@ void a3d_stack4f_pop(a3d_stack4f_t* self, a3d_mat4f_t* m)
 	assert(m);
 	LOGD("debug");
 
-	a3d_mat4f_t* c = (a3d_mat4f_t*) a3d_list_pop(self->matrix_stack);
-	if(c == NULL)
-		return;
-	a3d_mat4f_copy(c, m);
-	free(c);
+	a3d_array_pop(self->matrix_stack, (void*) m);
 }
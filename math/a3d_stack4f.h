@@ -26,12 +26,12 @@
 
 #include "../a3d_GL.h"
 
-#include "../a3d_list.h"
+#include "../a3d_array.h"
 #include "a3d_mat4f.h"
 
 typedef struct
 {
-	a3d_list_t* matrix_stack;
+	a3d_array_t* matrix_stack;
 } a3d_stack4f_t;
 
 a3d_stack4f_t* a3d_stack4f_new(void);